@@ -0,0 +1,109 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+
+#include <QPixmap>
+#include <QTest>
+
+#include "mediamanager.h"
+
+/**
+Checks and benchmarks gray scale conversion of MediaManager, From icon sizes to a full HD image
+*/
+class GrayScaleTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void convertToGrayScale_data();
+    void convertToGrayScale();
+    void benchmarkConvertToGrayScale_data();
+    void benchmarkConvertToGrayScale();
+
+private:
+    /**
+    @return A colorful half transparent pixmap of @p size
+    */
+    static QPixmap createPixmap(const QSize &size);
+};
+
+QPixmap GrayScaleTest::createPixmap(const QSize &size)
+{
+    QImage image(size, QImage::Format_ARGB32);
+    for (int y = 0; y < size.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            line[x] = qRgba((x * 7) & 0xff, (y * 13) & 0xff, (x + y) & 0xff, x % 2 ? 0xff : 0x80);
+        }
+    }
+    return QPixmap::fromImage(image);
+}
+
+static void addSizes()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::newRow("16px") << QSize(16, 16);
+    QTest::newRow("64px") << QSize(64, 64);
+    QTest::newRow("256px") << QSize(256, 256);
+    QTest::newRow("1080p") << QSize(1920, 1080);
+}
+
+void GrayScaleTest::convertToGrayScale_data()
+{
+    addSizes();
+}
+
+void GrayScaleTest::convertToGrayScale()
+{
+    QFETCH(QSize, size);
+    const QPixmap pixmap = createPixmap(size);
+    const QImage source = pixmap.toImage().convertToFormat(QImage::Format_ARGB32);
+    const QImage gray = Choqok::MediaManager::convertToGrayScale(pixmap).toImage().convertToFormat(QImage::Format_ARGB32);
+    QCOMPARE(gray.size(), size);
+    for (int y = 0; y < size.height(); y += qMax(1, size.height() / 16)) {
+        for (int x = 0; x < size.width(); x += qMax(1, size.width() / 16)) {
+            const QRgb pixel = gray.pixel(x, y);
+            QCOMPARE(qRed(pixel), qGreen(pixel));
+            QCOMPARE(qGreen(pixel), qBlue(pixel));
+            QCOMPARE(qAlpha(pixel), qAlpha(source.pixel(x, y)));
+            // Premultiplied rounding differs by a little on half transparent pixels
+            QVERIFY(qAbs(qRed(pixel) - qGray(source.pixel(x, y))) <= 4);
+        }
+    }
+}
+
+void GrayScaleTest::benchmarkConvertToGrayScale_data()
+{
+    addSizes();
+}
+
+void GrayScaleTest::benchmarkConvertToGrayScale()
+{
+    QFETCH(QSize, size);
+    const QPixmap pixmap = createPixmap(size);
+    QBENCHMARK {
+        Choqok::MediaManager::convertToGrayScale(pixmap);
+    }
+}
+
+QTEST_MAIN(GrayScaleTest)
+
+#include "grayscaletest.moc"
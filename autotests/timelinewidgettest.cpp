@@ -0,0 +1,196 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+
+#include <QDir>
+#include <QScrollArea>
+#include <QScrollBar>
+#include <QStandardPaths>
+#include <QTest>
+
+#include "account.h"
+#include "choqokbehaviorsettings.h"
+#include "choqoktypes.h"
+#include "microblog.h"
+#include "poststore.h"
+#include "timelinewidget.h"
+
+using namespace Choqok;
+
+/**
+A microblog without network, Which counts timeline loads
+*/
+class TestMicroBlog : public MicroBlog
+{
+public:
+    TestMicroBlog()
+        : MicroBlog(QStringLiteral("choqok_timelinewidgettest")), loads(0)
+    {
+        setTimelineNames(QStringList() << QStringLiteral("Home"));
+        info.name = QStringLiteral("Home");
+    }
+
+    ChoqokEditAccountWidget *createEditAccountWidget(Account *, QWidget *) override
+    {
+        return nullptr;
+    }
+
+    TimelineInfo *timelineInfo(const QString &) override
+    {
+        return &info;
+    }
+
+    QList<Post *> loadTimeline(Account *account, const QString &timelineName, int count,
+                               const Post *before) override
+    {
+        ++loads;
+        return MicroBlog::loadTimeline(account, timelineName, count, before);
+    }
+
+    int loads;
+    TimelineInfo info;
+};
+
+class TimelineWidgetTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void shortTimelineSettles();
+    void benchmarkAddNewPosts();
+
+private:
+    /**
+    @return @p count read posts, One minute apart, With ids from @p first on
+    */
+    static QList<Post *> createPosts(int first, int count);
+
+    /**
+    Store @p count read posts on Home timeline
+    */
+    void storePosts(int count);
+
+    TestMicroBlog *microblog;
+    Account *account;
+};
+
+void TimelineWidgetTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TimelineWidgetTest::init()
+{
+    QDir(QStandardPaths::writableLocation(QStandardPaths::DataLocation)).removeRecursively();
+    microblog = new TestMicroBlog;
+    account = new Account(microblog, QStringLiteral("test"));
+}
+
+void TimelineWidgetTest::cleanup()
+{
+    delete microblog;
+}
+
+QList<Post *> TimelineWidgetTest::createPosts(int first, int count)
+{
+    QList<Post *> posts;
+    const QDateTime start = QDateTime::currentDateTimeUtc().addDays(-10);
+    for (int i = first; i < first + count; ++i) {
+        Post *post = new Post;
+        post->postId = QString::number(i);
+        post->creationDateTime = start.addSecs(60 * i);
+        post->content = QStringLiteral("Post number %1 about #choqok and https://kde.org").arg(i);
+        post->author.userName = QStringLiteral("someone");
+        post->isRead = true;
+        posts.append(post);
+    }
+    return posts;
+}
+
+void TimelineWidgetTest::storePosts(int count)
+{
+    const QList<Post *> posts = createPosts(0, count);
+    microblog->postStore(account, QStringLiteral("Home"))->save(posts);
+    qDeleteAll(posts);
+}
+
+void TimelineWidgetTest::shortTimelineSettles()
+{
+    // Retained posts are much shorter than the viewport, So older pages are loaded right away
+    BehaviorSettings::setCountOfPosts(5);
+    BehaviorSettings::setMarkAllAsReadOnExit(true);
+    storePosts(60);
+
+    UI::TimelineWidget timeline(account, QStringLiteral("Home"));
+    timeline.resize(400, 800);
+    timeline.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&timeline));
+    QTest::qWait(2000);
+    // The newest page, Then pages of 25 until an empty one
+    QVERIFY(microblog->loads <= 5);
+    int loads = microblog->loads;
+    QTest::qWait(2000);
+    QCOMPARE(microblog->loads, loads);
+
+    // Going to newest posts may page out older ones, But going back pages them in once
+    QScrollBar *bar = timeline.findChild<QScrollArea *>()->verticalScrollBar();
+    for (int i = 0; i < 3; ++i) {
+        bar->setValue(bar->minimum());
+        QTest::qWait(500);
+        bar->setValue(bar->maximum());
+        QTest::qWait(500);
+    }
+    loads = microblog->loads;
+    QTest::qWait(2000);
+    QCOMPARE(microblog->loads, loads);
+}
+
+void TimelineWidgetTest::benchmarkAddNewPosts()
+{
+    // A page of 200 posts, A quarter of them already shown, Arrives on a timeline of 1000 posts
+    // Limits leave room for all of them, So only adding is measured
+    BehaviorSettings::setCountOfPosts(2000);
+    BehaviorSettings::setTotalCountOfPosts(5000);
+    BehaviorSettings::setMarkAllAsReadOnExit(true);
+    storePosts(1000);
+
+    UI::TimelineWidget timeline(account, QStringLiteral("Home"));
+    timeline.resize(400, 800);
+    timeline.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&timeline));
+    QCOMPARE(timeline.posts().count(), 1000);
+
+    QList<Post *> page = createPosts(950, 200);
+    const QList<Post *> known = page.mid(0, 50);
+    QBENCHMARK_ONCE {
+        timeline.addNewPosts(page);
+    }
+    QCOMPARE(timeline.posts().count(), 1150);
+    // Known posts are left to caller
+    qDeleteAll(known);
+}
+
+QTEST_MAIN(TimelineWidgetTest)
+
+#include "timelinewidgettest.moc"
@@ -0,0 +1,244 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+
+#include <QElapsedTimer>
+#include <QRegExp>
+#include <QStringList>
+#include <QTest>
+
+#include "urlutils.h"
+
+/**
+The regular expressions UrlUtils used before its tokenizer, Kept as reference of expected results
+*/
+namespace Reference
+{
+
+static const QString protocols = QLatin1String("((https?|ftps?)://)");
+static const QString subdomains = QLatin1String("(([a-z0-9\\-_]{1,}\\.)?)");
+static const QString auth = QLatin1String("(([a-z0-9\\-_]{1,})((:[\\S]{1,})?)@)");
+static const QString domains = QLatin1String("(([a-z0-9\\-\\x0080-\\xFFFF_]){1,63}\\.)+");
+static const QString port = QLatin1String("(:(6553[0-5]|655[0-2][0-9]|65[0-4][\\d]{2}|6[0-4][\\d]{3}|[1-5][\\d]{4}|[1-9][\\d]{0,3}))");
+// The old zone was a QLatin1String, Which mangled the non Latin TLDs; UrlUtils matches them as intended
+static const QString zone = QStringLiteral("((a[cdefgilmnoqrstuwxz])|(b[abdefghijlmnorstvwyz])|(c[acdfghiklmnoruvxyz])|(d[ejkmoz])|(e[ceghrstu])|\
+(f[ijkmor])|(g[abdefghilmnpqrstuwy])|(h[kmnrtu])|(i[delmnoqrst])|(j[emop])|(k[eghimnprwyz])|(l[abcikrstuvy])|\
+(m[acdefghklmnopqrstuvwxyz])|(n[acefgilopruz])|(om)|(p[aefghklnrstwy])|(qa)|(r[eosuw])|(s[abcdeghijklmnortuvyz])|\
+(t[cdfghjkmnoprtvwz])|(u[agksyz])|(v[aceginu])|(w[fs])|(ye)|(z[amrw])\
+|(asia|com|info|net|org|biz|name|pro|aero|cat|coop|edu|jobs|mobi|museum|tel|travel|gov|int|mil|local|xxx)|(中国)|(公司)|(网络)|(صر)|(امارات)|(рф))");
+static const QString ip = QLatin1String("(25[0-5]|[2][0-4][0-9]|[0-1]?[\\d]{1,2})(\\.(25[0-5]|[2][0-4][0-9]|[0-1]?[\\d]{1,2})){3}");
+static const QString params = QLatin1String("(((\\/)[\\w:/\\?#\\[\\]@!\\$&\\(\\)\\*%\\+,;=\\._~\\x0080-\\xFFFF\\-\\|]{1,}|%[0-9a-f]{2})?)");
+static const QString excludingCharacters = QStringLiteral("[^\\s`!()\\[\\]{};:'\".,<>?%1%2%3%4%5%6]")
+        .arg(QChar(0x00AB)).arg(QChar(0x00BB)).arg(QChar(0x201C)).arg(QChar(0x201D)).arg(QChar(0x2018)).arg(QChar(0x2019));
+
+static const QRegExp urlRegExp(QLatin1String("(((((") + protocols + auth + QLatin1String("?)?)") +
+                               subdomains +
+                               QLatin1Char('(') + domains +
+                               zone + QLatin1String("(?!(\\w))))|(") + protocols + QLatin1Char('(') + ip + QLatin1String(")+))") +
+                               QLatin1Char('(') + port + QLatin1String("?)") + QLatin1String("((\\/)?)")  +
+                               params + QLatin1Char(')') + excludingCharacters, Qt::CaseInsensitive);
+
+static const QRegExp emailRegExp(QLatin1Char('^') + auth + subdomains + domains + zone);
+static const QString hrefTemplate = QLatin1String("<a href='%1' title='%1'>%2</a>");
+
+static bool isSigil(QChar c)
+{
+    return c == QLatin1Char('@') || c == QLatin1Char('#') || c == QLatin1Char('!');
+}
+
+QStringList detectUrls(const QString &text)
+{
+    QStringList detectedUrls;
+    QRegExp regExp(urlRegExp);
+    int pos = 0;
+    while ((pos = regExp.indexIn(text, pos)) != -1) {
+        const QString link = regExp.cap(0);
+        if (pos == 0 || !isSigil(text.at(pos - 1))) {
+            detectedUrls << link;
+        }
+        pos += link.length();
+    }
+    return detectedUrls;
+}
+
+QString detectEmails(const QString &text)
+{
+    QString mailtoText(text);
+    QRegExp regExp(emailRegExp);
+    int pos = 0;
+    while ((pos = regExp.indexIn(mailtoText, pos)) != -1) {
+        const QString link = regExp.cap(0);
+        QString tmplink = link;
+        if (pos == 0 || !isSigil(mailtoText.at(pos - 1))) {
+            tmplink = hrefTemplate.arg(QLatin1String("mailto:") + link, link);
+            mailtoText.replace(pos, link.length(), tmplink);
+        }
+        pos += tmplink.length();
+    }
+    return mailtoText;
+}
+
+}
+
+/**
+Compares UrlUtils with the regular expressions it replaced on a corpus of texts
+*/
+class UrlUtilsTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void detectUrls_data();
+    void detectUrls();
+    void detectEmails_data();
+    void detectEmails();
+    void benchmark_data();
+    void benchmark();
+
+private:
+    static QStringList corpus();
+};
+
+/**
+@return Hand written texts, And texts generated from fragments which stress the grammar
+*/
+QStringList UrlUtilsTest::corpus()
+{
+    QStringList texts = {
+        QStringLiteral("http://example.com"),
+        QStringLiteral("see https://kde.org/applications/ now"),
+        QStringLiteral("www.example.com."),
+        QStringLiteral("example.com/"),
+        QStringLiteral("example.com/path?x=1,"),
+        QStringLiteral("visit EXAMPLE.COM/Now and Example.Org/"),
+        QStringLiteral("user:pass@host.example.org/x"),
+        QStringLiteral("http://user:p@ss@example.com/"),
+        QStringLiteral("http://192.168.0.1:8080/index.html"),
+        QStringLiteral("ftp://10.0.0.1/ ftps://10.0.0.256/"),
+        QStringLiteral("http://1.2.3.4.5.6.7.8/"),
+        QStringLiteral("http://255.255.255.2550/"),
+        QStringLiteral("(http://example.com/foo_(bar))"),
+        QStringLiteral("@example.com/ #example.com/ !example.com/"),
+        QStringLiteral("#seehttp://example.com/ @me:http://example.com/"),
+        QStringLiteral("http://中国.中国/ пример.рф/ موقع.امارات/"),
+        QStringLiteral("http://example.com:65535/ http://example.com:65536/ http://example.com:0/"),
+        QStringLiteral("http://localhost/ http://local.local/"),
+        QStringLiteral("a.b.c.d.e.f.g.h.com/"),
+        QStringLiteral("%1.com/ x.%1.com/ %2.com/").arg(QString(63, QLatin1Char('a')), QString(64, QLatin1Char('b'))),
+        QStringLiteral("«https://example.com/» “www.example.net/” ‘example.org/’"),
+        QStringLiteral("http://example.com/%20 example.com%20 example.com/%zz"),
+        QStringLiteral("https://example.com/a|b https://example.com/~user/"),
+        QStringLiteral("ftps://user@ftp.example.co.uk:21/pub/"),
+        QStringLiteral("under_score.example.com/ -dash-.example.com/"),
+        QStringLiteral("nested http://https://example.com/"),
+        QStringLiteral("example.comx/ example.com_/ example.com-/"),
+        QStringLiteral("https://example.com/path/to/page.html?query=1&other=two#anchor!"),
+        QStringLiteral("<a href='http://example.com/'>http://example.com/</a>"),
+        QStringLiteral("http://example.com/ü/é/日本/"),
+        QStringLiteral("john@example.com"),
+        QStringLiteral("John@Example.COM"),
+        QStringLiteral("john.doe@example.com"),
+        QStringLiteral("john:secret@mail.example.org rest"),
+        QStringLiteral("x@y"),
+        QStringLiteral("a@b.c@d.com"),
+        QStringLiteral(""),
+        QStringLiteral("no links at all, just text."),
+    };
+
+    static const char *const fragments[] = {
+        "http://", "https://", "HTTP://", "ftp://", "ftps://", "www.", "example", "kde", "a", "x1", "-", "_",
+        ".", "..", ".com", ".org", ".co", ".uk", ".de", ".ir", ".museum", ".local", ".comx", ".COM",
+        "user", ":", "pass", "@", "#", "!", "/", "//", "path", "?q=1&b=2", "%20", "%zz", ":8080", ":65535",
+        ":65536", ":0", "192.168.1.1", "10.0.0.255", "256.1.1.1", "1.2.3.4.5", " ", " ", " ", "\n", "\t",
+        ",", ";", "(", ")", "[", "]", "'", "\"", "<", ">", "`", "|", "~", "*", "+", "=", "$", "&",
+        "\xc3\xa9", "\xc3\xbc", "\xe6\x97\xa5\xe6\x9c\xac", "\xc2\xab", "\xc2\xbb", "\xe2\x80\x9c", "\xe2\x80\x9d",
+        "\xe2\x80\x98", "\xe2\x80\x99", ".\xe4\xb8\xad\xe5\x9b\xbd", ".\xd1\x80\xd1\x84"
+    };
+    const int fragmentCount = int(sizeof(fragments) / sizeof(fragments[0]));
+    // Fixed seed, So failures are reproducible
+    quint32 state = 20200101;
+    const auto next = [&state](int bound) {
+        state = state * 1664525u + 1013904223u;
+        return int((state >> 8) % quint32(bound));
+    };
+    for (int i = 0; i < 3000; ++i) {
+        QString text;
+        const int count = 1 + next(12);
+        for (int j = 0; j < count; ++j) {
+            text += QString::fromUtf8(fragments[next(fragmentCount)]);
+        }
+        texts.append(text);
+    }
+    return texts;
+}
+
+void UrlUtilsTest::detectUrls_data()
+{
+    QTest::addColumn<QString>("text");
+    const QStringList texts = corpus();
+    for (int i = 0; i < texts.count(); ++i) {
+        QTest::newRow(qPrintable(QStringLiteral("text %1").arg(i))) << texts.at(i);
+    }
+}
+
+void UrlUtilsTest::detectUrls()
+{
+    QFETCH(QString, text);
+    QCOMPARE(UrlUtils::detectUrls(text), Reference::detectUrls(text));
+}
+
+void UrlUtilsTest::detectEmails_data()
+{
+    detectUrls_data();
+}
+
+void UrlUtilsTest::detectEmails()
+{
+    QFETCH(QString, text);
+    QCOMPARE(UrlUtils::detectEmails(text), Reference::detectEmails(text));
+}
+
+void UrlUtilsTest::benchmark_data()
+{
+    QTest::addColumn<bool>("reference");
+    QTest::newRow("tokenizer") << false;
+    QTest::newRow("regexp") << true;
+}
+
+void UrlUtilsTest::benchmark()
+{
+    QFETCH(bool, reference);
+    const QString text = corpus().join(QLatin1Char('\n'));
+    qint64 bytes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        const QStringList urls = reference ? Reference::detectUrls(text) : UrlUtils::detectUrls(text);
+        Q_UNUSED(urls);
+        bytes += text.size() * qint64(sizeof(QChar));
+    }
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    qInfo() << (reference ? "QRegExp:" : "Tokenizer:") << bytes / 1e6 / seconds << "MB/s";
+}
+
+QTEST_GUILESS_MAIN(UrlUtilsTest)
+
+#include "urlutilstest.moc"
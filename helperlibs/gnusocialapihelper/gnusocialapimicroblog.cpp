@@ -25,12 +25,10 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include <QMimeDatabase>
 
 #include <KIO/StoredTransferJob>
 #include <KJobWidgets>
 #include <KLocalizedString>
-#include <KMessageBox>
 
 #include "account.h"
 #include "accountmanager.h"
@@ -38,6 +36,8 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include "composerwidget.h"
 #include "editaccountwidget.h"
 #include "mediamanager.h"
+#include "mediumreadjob.h"
+#include "multipartformdata.h"
 #include "microblogwidget.h"
 #include "postwidget.h"
 #include "timelinewidget.h"
@@ -189,60 +189,63 @@ void GNUSocialApiMicroBlog::createPostWithAttachment(Choqok::Account *theAccount
     if (mediumToAttach.isEmpty()) {
         TwitterApiMicroBlog::createPost(theAccount, post);
     } else {
-        const QUrl picUrl = QUrl::fromUserInput(mediumToAttach);
-        KIO::StoredTransferJob *picJob = KIO::storedGet(picUrl, KIO::Reload, KIO::HideProgressInfo);
-        picJob->exec();
-        if (picJob->error()) {
-            qCCritical(CHOQOK) << "Job error:" << picJob->errorString();
-            KMessageBox::detailedError(Choqok::UI::Global::mainWindow(),
-                                       i18n("Uploading medium failed: cannot read the medium file."),
-                                       picJob->errorString());
-            return;
-        }
-        const QByteArray picData = picJob->data();
-        if (picData.count() == 0) {
-            qCCritical(CHOQOK) << "Cannot read the media file, please check if it exists.";
-            KMessageBox::error(Choqok::UI::Global::mainWindow(),
-                               i18n("Uploading medium failed: cannot read the medium file."));
-            return;
-        }
-        ///Documentation: http://identi.ca/notice/17779990
-        TwitterApiAccount *account = qobject_cast<TwitterApiAccount *>(theAccount);
-        QUrl url = account->apiUrl();
-        url.setPath(url.path() + QLatin1String("/statuses/update.json"));
-        const QMimeDatabase db;
-        QByteArray fileContentType = db.mimeTypeForUrl(picUrl).name().toUtf8();
-
-        QMap<QString, QByteArray> formdata;
-        formdata[QLatin1String("status")] = post->content.toUtf8();
-        formdata[QLatin1String("in_reply_to_status_id")] = post->replyToPostId.toLatin1();
-        formdata[QLatin1String("source")] = QCoreApplication::applicationName().toLatin1();
-
-        QMap<QString, QByteArray> mediafile;
-        mediafile[QLatin1String("name")] = "media";
-        mediafile[QLatin1String("filename")] = picUrl.fileName().toUtf8();
-        mediafile[QLatin1String("mediumType")] = fileContentType;
-        mediafile[QLatin1String("medium")] = picData;
-        QList< QMap<QString, QByteArray> > listMediafiles;
-        listMediafiles.append(mediafile);
-
-        QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
-
-        KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
-        if (!job) {
-            qCCritical(CHOQOK) << "Cannot create a http POST request!";
-            return;
-        }
-        job->addMetaData(QStringLiteral("content-type"),
-                         QStringLiteral("Content-Type: multipart/form-data; boundary=AaB03x"));
-        job->addMetaData(QStringLiteral("customHTTPHeader"),
-                         QStringLiteral("Authorization: ") +
-                         QLatin1String(authorizationHeader(account, url, QNetworkAccessManager::PostOperation)));
-        mCreatePostMap[ job ] = post;
-        mJobsAccount[job] = theAccount;
-        connect(job, &KIO::StoredTransferJob::result, this, &GNUSocialApiMicroBlog::slotCreatePost);
-        job->start();
+        Choqok::MediumReadJob *readJob = new Choqok::MediumReadJob(QUrl::fromUserInput(mediumToAttach), this);
+        mCreatePostMap[readJob] = post;
+        mJobsAccount[readJob] = theAccount;
+        connect(readJob, &KJob::result, this, &GNUSocialApiMicroBlog::slotAttachmentRead);
+        readJob->start();
+    }
+}
+
+void GNUSocialApiMicroBlog::slotAttachmentRead(KJob *readJob)
+{
+    Choqok::Post *post = mCreatePostMap.take(readJob);
+    Choqok::Account *theAccount = mJobsAccount.take(readJob);
+    if (!post || !theAccount) {
+        qCDebug(CHOQOK) << "Account or Post is NULL pointer";
+        return;
+    }
+    if (readJob->error()) {
+        qCCritical(CHOQOK) << "Job error:" << readJob->errorString();
+        Q_EMIT errorPost(theAccount, post, Choqok::MicroBlog::OtherError,
+                         i18n("Uploading medium failed: cannot read the medium file: %1", readJob->errorString()),
+                         MicroBlog::Critical);
+        return;
+    }
+    Choqok::MediumReadJob *medium = qobject_cast<Choqok::MediumReadJob *>(readJob);
+    const QUrl picUrl = medium->url();
+    ///Documentation: http://identi.ca/notice/17779990
+    TwitterApiAccount *account = qobject_cast<TwitterApiAccount *>(theAccount);
+    QUrl url = account->apiUrl();
+    url.setPath(url.path() + QLatin1String("/statuses/update.json"));
+
+    QMap<QString, QByteArray> formdata;
+    formdata[QLatin1String("status")] = post->content.toUtf8();
+    formdata[QLatin1String("in_reply_to_status_id")] = post->replyToPostId.toLatin1();
+    formdata[QLatin1String("source")] = QCoreApplication::applicationName().toLatin1();
+
+    Choqok::MultipartFormData *form = new Choqok::MultipartFormData;
+    if (!form->addFile(QLatin1String("media"), picUrl, medium->mimeType(), medium->data())) {
+        delete form;
+        Q_EMIT errorPost(theAccount, post, Choqok::MicroBlog::OtherError,
+                         i18n("Uploading medium failed: the medium file is empty or cannot be read."),
+                         MicroBlog::Critical);
+        return;
     }
+    form->addFields(formdata);
+
+    KIO::StoredTransferJob *job = form->post(url);
+    if (!job) {
+        qCCritical(CHOQOK) << "Cannot create a http POST request!";
+        return;
+    }
+    job->addMetaData(QStringLiteral("customHTTPHeader"),
+                     QStringLiteral("Authorization: ") +
+                     QLatin1String(authorizationHeader(account, url, QNetworkAccessManager::PostOperation)));
+    mCreatePostMap[ job ] = post;
+    mJobsAccount[job] = theAccount;
+    connect(job, &KIO::StoredTransferJob::result, this, &GNUSocialApiMicroBlog::slotCreatePost);
+    job->start();
 }
 
 QString GNUSocialApiMicroBlog::generateRepeatedByUserTooltip(const QString &username)
@@ -81,6 +81,7 @@ protected:
 protected Q_SLOTS:
     void slotFetchConversation(KJob *job);
     void slotRequestFriendsScreenName(KJob *job);
+    void slotAttachmentRead(KJob *readJob);
 
 private:
     void doRequestFriendsScreenName(TwitterApiAccount *theAccount, int page);
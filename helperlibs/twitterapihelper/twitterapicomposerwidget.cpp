@@ -55,8 +55,8 @@ TwitterApiComposerWidget::TwitterApiComposerWidget(Choqok::Account *account, QWi
     completer->setCaseSensitivity(Qt::CaseInsensitive);
     edit->setCompleter(completer);
     setEditor(edit);
-    connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetAdded,
-            this, &TwitterApiComposerWidget::slotNewPostReady);
+    connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetsAdded,
+            this, &TwitterApiComposerWidget::slotNewPostsReady);
 }
 
 TwitterApiComposerWidget::~TwitterApiComposerWidget()
@@ -64,14 +64,19 @@ TwitterApiComposerWidget::~TwitterApiComposerWidget()
     delete d;
 }
 
-void TwitterApiComposerWidget::slotNewPostReady(Choqok::UI::PostWidget *widget, Choqok::Account *theAccount)
+void TwitterApiComposerWidget::slotNewPostsReady(const QList<Choqok::UI::PostWidget *> &widgets, Choqok::Account *theAccount)
 {
     if (theAccount == currentAccount()) {
-        QString name = widget->currentPost()->author.userName;
-        if (!name.isEmpty() && !d->model->stringList().contains(name)) {
-            int row = d->model->rowCount();
-            d->model->insertRow(row);
-            d->model->setData(d->model->index(row), name);
+        QStringList names = d->model->stringList();
+        const int oldCount = names.count();
+        for (Choqok::UI::PostWidget *widget: widgets) {
+            QString name = widget->currentPost()->author.userName;
+            if (!name.isEmpty() && !names.contains(name)) {
+                names.append(name);
+            }
+        }
+        if (names.count() != oldCount) {
+            d->model->setStringList(names);
         }
     }
 }
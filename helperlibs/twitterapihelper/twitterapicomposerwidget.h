@@ -42,7 +42,7 @@ public:
     ~TwitterApiComposerWidget();
 
 protected Q_SLOTS:
-    virtual void slotNewPostReady(Choqok::UI::PostWidget *widget, Choqok::Account *theAccount);
+    virtual void slotNewPostsReady(const QList<Choqok::UI::PostWidget *> &widgets, Choqok::Account *theAccount);
 
 private:
     class Private;
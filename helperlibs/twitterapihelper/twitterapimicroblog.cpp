@@ -36,6 +36,7 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include "application.h"
 #include "choqokappearancesettings.h"
 #include "choqokbehaviorsettings.h"
+#include "choqoktools.h"
 #include "choqokuiglobal.h"
 #include "editaccountwidget.h"
 #include "microblogwidget.h"
@@ -168,13 +169,23 @@ QMenu *TwitterApiMicroBlog::createActionsMenu(Choqok::Account *theAccount, QWidg
 }
 
 QList< Choqok::Post * > TwitterApiMicroBlog::loadTimeline(Choqok::Account *account,
-        const QString &timelineName)
+        const QString &timelineName, int count, const Choqok::Post *before)
 {
-    QList< Choqok::Post * > list;
     if (timelineName.compare(QLatin1String("Favorite")) == 0) {
-        return list;    //NOTE Won't cache favorites, and this is for compatibility with older versions!
+        return QList<Choqok::Post *>();    //NOTE Won't cache favorites, and this is for compatibility with older versions!
     }
     qCDebug(CHOQOK) << timelineName;
+    const QList<Choqok::Post *> list = Choqok::MicroBlog::loadTimeline(account, timelineName, count, before);
+    if (!before && !list.isEmpty()) {
+        mTimelineLatestId[account][timelineName] = list.last()->postId;
+    }
+    return list;
+}
+
+QList< Choqok::Post * > TwitterApiMicroBlog::loadTimelineBackup(Choqok::Account *account,
+        const QString &timelineName)
+{
+    QList< Choqok::Post * > list;
     QString fileName = Choqok::AccountManager::generatePostBackupFileName(account->alias(), timelineName);
     KConfig postsBackup(fileName, KConfig::NoGlobals, QStandardPaths::DataLocation);
     QStringList tmpList = postsBackup.groupList();
@@ -185,17 +196,12 @@ QList< Choqok::Post * > TwitterApiMicroBlog::loadTimeline(Choqok::Account *accou
     }
 ///--------------
 
-    QList<QDateTime> groupList;
-    for (const QString &str: tmpList) {
-        groupList.append(QDateTime::fromString(str));
-    }
-    std::sort(groupList.begin(), groupList.end());
-    int count = groupList.count();
+    int count = tmpList.count();
     if (count) {
         Choqok::Post *st = nullptr;
         for (int i = 0; i < count; ++i) {
             st = new Choqok::Post;
-            KConfigGroup grp(&postsBackup, groupList[i].toString());
+            KConfigGroup grp(&postsBackup, tmpList[i]);
             st->creationDateTime = grp.readEntry("creationDateTime", QDateTime::currentDateTime());
             st->postId = grp.readEntry("postId", QString());
             st->content = grp.readEntry("text", QString());
@@ -228,7 +234,6 @@ QList< Choqok::Post * > TwitterApiMicroBlog::loadTimeline(Choqok::Account *accou
 
             list.append(st);
         }
-        mTimelineLatestId[account][timelineName] = st->postId;
     }
     return list;
 }
@@ -239,47 +244,7 @@ void TwitterApiMicroBlog::saveTimeline(Choqok::Account *account,
 {
     if (timelineName.compare(QLatin1String("Favorite")) != 0) {
         qCDebug(CHOQOK);
-        QString fileName = Choqok::AccountManager::generatePostBackupFileName(account->alias(), timelineName);
-        KConfig postsBackup(fileName, KConfig::NoGlobals, QStandardPaths::DataLocation);
-
-        ///Clear previous data:
-        for (const QString &group: postsBackup.groupList()) {
-            postsBackup.deleteGroup(group);
-        }
-
-        for (Choqok::UI::PostWidget *wd: timeline) {
-            const Choqok::Post *post = (wd->currentPost());
-            KConfigGroup grp(&postsBackup, post->creationDateTime.toString());
-            grp.writeEntry("creationDateTime", post->creationDateTime);
-            grp.writeEntry("postId", post->postId);
-            grp.writeEntry("text", post->content);
-            grp.writeEntry("source", post->source);
-            grp.writeEntry("inReplyToPostId", post->replyToPostId);
-            grp.writeEntry("inReplyToUserId", post->replyToUser.userId);
-            grp.writeEntry("favorited", post->isFavorited);
-            grp.writeEntry("inReplyToUserName", post->replyToUser.userName);
-            grp.writeEntry("authorId", post->author.userId);
-            grp.writeEntry("authorUserName", post->author.userName);
-            grp.writeEntry("authorRealName", post->author.realName);
-            grp.writeEntry("authorHomePageUrl", post->author.homePageUrl);
-            grp.writeEntry("authorProfileImageUrl", post->author.profileImageUrl);
-            grp.writeEntry("authorDescription" , post->author.description);
-            grp.writeEntry("isPrivate" , post->isPrivate);
-            grp.writeEntry("authorLocation" , post->author.location);
-            grp.writeEntry("isProtected" , post->author.isProtected);
-            grp.writeEntry("isRead" , post->isRead);
-            grp.writeEntry("repeatedFrom", post->repeatedFromUser.userName);
-            grp.writeEntry("repeatedFromUserHomePage", post->repeatedFromUser.homePageUrl);
-            grp.writeEntry("repeatedPostId", post->repeatedPostId);
-            grp.writeEntry("repeatedDateTime", post->repeatedDateTime);
-            grp.writeEntry("conversationId", post->conversationId);
-            grp.writeEntry("mediaUrl", post->media);
-            grp.writeEntry("quotedPostId", post->quotedPost.postId);
-            grp.writeEntry("quotedProfileUrl", post->quotedPost.user.profileImageUrl);
-            grp.writeEntry("quotedContent", post->quotedPost.content);
-            grp.writeEntry("quotedUsername", post->quotedPost.user.userName);
-        }
-        postsBackup.sync();
+        Choqok::MicroBlog::saveTimeline(account, timelineName, timeline);
     }
     if (Choqok::Application::isShuttingDown()) {
         --d->countOfTimelinesToSave;
@@ -990,6 +955,7 @@ void TwitterApiMicroBlog::setQuotedPost(Choqok::Post* post, Choqok::Post* quoted
     post->quotedPost.user.userName = quotedPost->author.userName;
     post->quotedPost.postId = quotedPost->postId;
     post->quotedPost.content = quotedPost->content;
+    post->quotedPost.direction = quotedPost->direction;
 }
 
 QDateTime TwitterApiMicroBlog::dateFromString(const QString &date)
@@ -1403,6 +1369,7 @@ Choqok::Post *TwitterApiMicroBlog::readPost(Choqok::Account *theAccount,
         setQuotedPost(post, quotedPost);
         delete quotedPost;
     }
+    post->direction = Choqok::textDirection(post->content);
     post->link = postUrl(theAccount, post->author.userName, post->postId);
     post->isRead = post->isFavorited || (post->repeatedFromUser.userName.compare(theAccount->username(), Qt::CaseInsensitive) == 0);
 
@@ -44,7 +44,8 @@ public:
 
     virtual QMenu *createActionsMenu(Choqok::Account *theAccount,
                                      QWidget *parent = Choqok::UI::Global::mainWindow()) override;
-    virtual QList< Choqok::Post * > loadTimeline(Choqok::Account *accountAlias, const QString &timelineName) override;
+    virtual QList< Choqok::Post * > loadTimeline(Choqok::Account *accountAlias, const QString &timelineName,
+                                                 int count = -1, const Choqok::Post *before = nullptr) override;
     virtual void saveTimeline(Choqok::Account *account, const QString &timelineName,
                               const QList< Choqok::UI::PostWidget * > &timeline) override;
 
@@ -203,6 +204,7 @@ protected Q_SLOTS:
 
 protected:
     TwitterApiMicroBlog(const QString &componentName, QObject *parent = nullptr);
+    virtual QList< Choqok::Post * > loadTimelineBackup(Choqok::Account *account, const QString &timelineName) override;
     /**
      Request update for @p timelineName timeline.
      timelineName should be a valid, previously created timeline.
@@ -40,7 +40,7 @@
 #include "twitterapimicroblog.h"
 #include "twitterapishowthread.h"
 
-const QIcon TwitterApiPostWidget::unFavIcon(Choqok::MediaManager::convertToGrayScale(QIcon::fromTheme(QLatin1String("rating")).pixmap(16)));
+const QIcon TwitterApiPostWidget::unFavIcon(Choqok::MediaManager::grayScaleIcon(QLatin1String("rating"), 16));
 
 class TwitterApiPostWidget::Private
 {
@@ -222,6 +222,7 @@ void TwitterApiPostWidget::slotSetFavorite(Choqok::Account *theAccount, const QS
         qCDebug(CHOQOK) << postId;
         currentPost()->isFavorited = !currentPost()->isFavorited;
         updateFavStat();
+        Q_EMIT postChanged();
         disconnect(d->mBlog, &TwitterApiMicroBlog::favoriteRemoved, this, &TwitterApiPostWidget::slotSetFavorite);
         disconnect(d->mBlog, &TwitterApiMicroBlog::favoriteCreated, this, &TwitterApiPostWidget::slotSetFavorite);
     }
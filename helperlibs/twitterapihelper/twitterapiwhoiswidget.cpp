@@ -199,16 +199,11 @@ void TwitterApiWhoisWidget::userInfoReceived(KJob *job)
     showForm();
 
     QPixmap userAvatar = Choqok::MediaManager::self()->fetchImage(post.author.profileImageUrl,
-                         Choqok::MediaManager::Async);
+                         this, "avatarFetched", "avatarFetchError");
 
     if (!userAvatar.isNull()) {
         d->wid->document()->addResource(QTextDocument::ImageResource, QUrl(QLatin1String("img://profileImage")),
                                         userAvatar);
-    } else {
-        connect(Choqok::MediaManager::self(), &Choqok::MediaManager::imageFetched,
-                this, &TwitterApiWhoisWidget::avatarFetched);
-        connect(Choqok::MediaManager::self(), &Choqok::MediaManager::fetchError,
-                this, &TwitterApiWhoisWidget::avatarFetchError);
     }
 }
 
@@ -219,10 +214,6 @@ void TwitterApiWhoisWidget::avatarFetched(const QUrl &remoteUrl, const QPixmap &
         const QUrl url(QLatin1String("img://profileImage"));
         d->wid->document()->addResource(QTextDocument::ImageResource, url, pixmap);
         updateHtml();
-        disconnect(Choqok::MediaManager::self(), &Choqok::MediaManager::imageFetched,
-                   this, &TwitterApiWhoisWidget::avatarFetched);
-        disconnect(Choqok::MediaManager::self(), &Choqok::MediaManager::fetchError,
-                   this, &TwitterApiWhoisWidget::avatarFetchError);
     }
 }
 
@@ -231,7 +222,7 @@ void TwitterApiWhoisWidget::avatarFetchError(const QUrl &remoteUrl, const QStrin
     qCDebug(CHOQOK);
     Q_UNUSED(errMsg);
     if (remoteUrl == d->currentPost.author.profileImageUrl) {
-        ///Avatar fetching is failed! but will not disconnect to get the img if it fetches later!
+        ///Avatar fetching is failed!
         const QUrl url(QLatin1String("img://profileImage"));
         d->wid->document()->addResource(QTextDocument::ImageResource, url, QIcon::fromTheme(QLatin1String("image-missing")).pixmap(48));
         updateHtml();
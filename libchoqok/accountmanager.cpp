@@ -22,6 +22,7 @@
 */
 #include "accountmanager.h"
 
+#include <QFile>
 #include <QUrl>
 #include <QStandardPaths>
 
@@ -38,6 +39,8 @@
 #include "microblog.h"
 #include "passwordmanager.h"
 #include "pluginmanager.h"
+#include "poststore.h"
+#include "searchindex.h"
 
 namespace Choqok
 {
@@ -130,10 +133,15 @@ bool AccountManager::removeAccount(const QString &alias)
             if (!a) {
                 return false;
             }
-            QStringList names = a->timelineNames();
+            QStringList names;
+            for (const QString &name: a->timelineNames()) {
+                names << name << name + QLatin1String("_archive");
+            }
             while (!names.isEmpty()) {
+                const QString name = names.takeFirst();
+                QFile::remove(PostStore::filePath(a->alias(), name));
                 const QString tmpFile = QStandardPaths::locate(QStandardPaths::DataLocation,
-                                                               generatePostBackupFileName(a->alias(), names.takeFirst()));
+                                                               generatePostBackupFileName(a->alias(), name));
                 qCDebug(CHOQOK) << "Will remove" << tmpFile;
                 const QUrl path = QUrl::fromLocalFile(tmpFile);
 
@@ -146,6 +154,7 @@ bool AccountManager::removeAccount(const QString &alias)
                     delJob->exec();
                 }
             }
+            SearchIndex::self()->removeAccount(alias);
             a->deleteLater();
             PasswordManager::self()->removePassword(alias);
             Q_EMIT accountRemoved(alias);
@@ -53,6 +53,58 @@ void Choqok::openUrl(const QUrl &url)
         KMessageBox::error(Choqok::UI::Global::mainWindow(), failureMessage);
 }
 
+static inline bool isWordChar(QChar c)
+{
+    return c.isLetterOrNumber() || c.isMark() || c == QLatin1Char('_');
+}
+
+Qt::LayoutDirection Choqok::textDirection(const QString &text)
+{
+    const int length = text.length();
+    int i = 0;
+    while (i < length) {
+        const QChar c = text.at(i);
+        const bool wordStart = i == 0 || !isWordChar(text.at(i - 1));
+        if (wordStart && (c == QLatin1Char('@') || c == QLatin1Char('#') || c == QLatin1Char('!')) &&
+                i + 1 < length && isWordChar(text.at(i + 1))) {
+            i += 2;
+            while (i < length && isWordChar(text.at(i))) {
+                ++i;
+            }
+            continue;
+        }
+        if (wordStart && c == QLatin1Char('R') && i + 1 < length &&
+                (text.at(i + 1) == QLatin1Char('T') || text.at(i + 1) == QLatin1Char('D')) &&
+                (i + 2 == length || !isWordChar(text.at(i + 2)))) {
+            i += 2;
+            continue;
+        }
+        if (c.isHighSurrogate() && i + 1 < length && text.at(i + 1).isLowSurrogate()) {
+            const uint ucs4 = QChar::surrogateToUcs4(c, text.at(i + 1));
+            switch (QChar::direction(ucs4)) {
+            case QChar::DirL:
+                return Qt::LeftToRight;
+            case QChar::DirR:
+            case QChar::DirAL:
+                return Qt::RightToLeft;
+            default:
+                i += 2;
+                continue;
+            }
+        }
+        switch (c.direction()) {
+        case QChar::DirL:
+            return Qt::LeftToRight;
+        case QChar::DirR:
+        case QChar::DirAL:
+            return Qt::RightToLeft;
+        default:
+            ++i;
+        }
+    }
+    return Qt::LeftToRight;
+}
+
 QString Choqok::getColorString(const QColor &color)
 {
     return QLatin1String("rgb(") + QString::number(color.red()) + QLatin1Char(',') + QString::number(color.green()) + QLatin1Char(',') +
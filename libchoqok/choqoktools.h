@@ -36,6 +36,13 @@ void CHOQOK_EXPORT openUrl(const QUrl &url);
 
 QString CHOQOK_EXPORT getColorString(const QColor &color);
 
+/**
+@return Direction of the first strong character of @p text
+RT/RD markers and @mentions, #hashtags and !groups are skipped, Because they don't tell anything
+about the language of text. Returns Qt::LeftToRight if no strong character is found.
+*/
+Qt::LayoutDirection CHOQOK_EXPORT textDirection(const QString &text);
+
 }
 
 #endif // CHOQOK_CHOQOKTOOLS_H
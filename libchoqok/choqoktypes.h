@@ -62,16 +62,21 @@ public:
 class CHOQOK_EXPORT QuotedPost
 {
 public:
+    QuotedPost()
+        : direction(Qt::LayoutDirectionAuto)
+    {}
+
     User user;
     QString postId;
     QString content;
+    Qt::LayoutDirection direction; // of content, see Post::direction
 };
 
 class CHOQOK_EXPORT Post
 {
 public:
     Post()
-        : isFavorited(false), isPrivate(false), isError(false), isRead(false), owners(0)
+        : isFavorited(false), isPrivate(false), isError(false), isRead(false), direction(Qt::LayoutDirectionAuto), owners(0)
     {}
     Post(const Post& u) = default;
     Post(Post&& u) = default;
@@ -98,6 +103,7 @@ public:
     QString conversationId;
     QUrl media;          // first Image of Post, if available
     QuotedPost quotedPost;
+    Qt::LayoutDirection direction; // of content, Set by microblog on parse. Qt::LayoutDirectionAuto if not detected yet
     unsigned int owners; // number of associated PostWidgets
 };
 /**
@@ -23,6 +23,7 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include "choqokuiglobal.h"
 
 #include <QApplication>
+#include <QMetaMethod>
 #include <QPointer>
 
 #include "notifymanager.h"
@@ -82,7 +83,30 @@ UI::Global::SessionManager *UI::Global::SessionManager::self()
 void UI::Global::SessionManager::emitNewPostWidgetAdded(UI::PostWidget *widget, Choqok::Account *theAccount,
         const QString &timelineName)
 {
-    Q_EMIT newPostWidgetAdded(widget, theAccount, timelineName);
+    emitNewPostWidgetsAdded(QList<UI::PostWidget *>() << widget, theAccount, timelineName);
+}
+
+void UI::Global::SessionManager::emitNewPostWidgetsAdded(const QList<UI::PostWidget *> &widgets,
+        Choqok::Account *theAccount, const QString &timelineName)
+{
+    if (widgets.isEmpty()) {
+        return;
+    }
+    Q_EMIT newPostWidgetsAdded(widgets, theAccount, timelineName);
+    static const QMetaMethod singleSignal = QMetaMethod::fromSignal(&SessionManager::newPostWidgetAdded);
+    if (isSignalConnected(singleSignal)) {
+        for (UI::PostWidget *widget: widgets) {
+            Q_EMIT newPostWidgetAdded(widget, theAccount, timelineName);
+        }
+    }
+}
+
+void UI::Global::SessionManager::emitPostWidgetsAdding(const QList<UI::PostWidget *> &widgets,
+        Choqok::Account *theAccount, const QString &timelineName)
+{
+    if (!widgets.isEmpty()) {
+        Q_EMIT postWidgetsAdding(widgets, theAccount, timelineName);
+    }
 }
 
 void UI::Global::SessionManager::resetNotifyManager()
@@ -24,6 +24,7 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #ifndef CHOQOKUIGLOBAL_H
 #define CHOQOKUIGLOBAL_H
 
+#include <QList>
 #include <QObject>
 
 #include "choqokmainwindow.h"
@@ -69,11 +70,34 @@ public:
     static SessionManager *self();
     void emitNewPostWidgetAdded(Choqok::UI::PostWidget *widget, Choqok::Account *theAccount,
                                 const QString &timelineName = QString());
+    void emitNewPostWidgetsAdded(const QList<Choqok::UI::PostWidget *> &widgets, Choqok::Account *theAccount,
+                                 const QString &timelineName = QString());
+    void emitPostWidgetsAdding(const QList<Choqok::UI::PostWidget *> &widgets, Choqok::Account *theAccount,
+                               const QString &timelineName = QString());
 
 Q_SIGNALS:
+    /**
+    Emitted for each added PostWidget, only when something is connected to it.
+    Prefer @ref newPostWidgetsAdded() on new code.
+    */
     void newPostWidgetAdded(Choqok::UI::PostWidget *widget, Choqok::Account *theAccount,
                             const QString &timelineName);
 
+    /**
+    Emitted once for a batch of PostWidgets added to a timeline
+    */
+    void newPostWidgetsAdded(const QList<Choqok::UI::PostWidget *> &widgets, Choqok::Account *theAccount,
+                             const QString &timelineName);
+
+    /**
+    Emitted once for a batch of PostWidgets added to a timeline, Before their UI is initialized
+    Only @ref PostWidget::currentPost() is ready, Timelines initialize posts when they come near viewport.
+    Plugins which decide on post data, e.g. filters hiding posts, Use it so posts don't show before that.
+    @ref newPostWidgetsAdded() follows for posts which are still open when initialized.
+    */
+    void postWidgetsAdding(const QList<Choqok::UI::PostWidget *> &widgets, Choqok::Account *theAccount,
+                           const QString &timelineName);
+
 public Q_SLOTS:
     void resetNotifyManager();
 
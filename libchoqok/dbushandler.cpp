@@ -33,6 +33,7 @@
 #include "ChoqokAdaptor.h"
 #include "choqokbehaviorsettings.h"
 #include "libchoqokdebug.h"
+#include "mediamanager.h"
 #include "quickpost.h"
 #include "shortenmanager.h"
 #include "uploadmediadialog.h"
@@ -148,6 +149,21 @@ bool DbusHandler::getShortening()
     return Choqok::BehaviorSettings::shortenOnPaste();
 }
 
+qlonglong DbusHandler::getImageCacheHits()
+{
+    return MediaManager::self()->imageCacheHits();
+}
+
+qlonglong DbusHandler::getImageCacheMisses()
+{
+    return MediaManager::self()->imageCacheMisses();
+}
+
+qlonglong DbusHandler::getImageCacheEvictions()
+{
+    return MediaManager::self()->imageCacheEvictions();
+}
+
 DbusHandler *ChoqokDbus()
 {
     if (DbusHandler::m_self == nullptr) {
@@ -57,6 +57,7 @@ public Q_SLOTS:
      *   shareUrl: if you want to share an url with the html page title set bool title true;
      *   getShortening: return a bool for the active configuration of ShortenOnPaste option;
      *   setShortening: Control ShortenOnPaste option;
+     *   getImageCache*: return statistics of memory cache of images;
      */
 
     void shareUrl(const QString &url, bool title = false);
@@ -65,6 +66,9 @@ public Q_SLOTS:
     void updateTimelines();
     void setShortening(bool flag);
     bool getShortening();
+    qlonglong getImageCacheHits();
+    qlonglong getImageCacheMisses();
+    qlonglong getImageCacheEvictions();
 
 private:
     static DbusHandler *m_self;
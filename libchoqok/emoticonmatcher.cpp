@@ -0,0 +1,259 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+#include "emoticonmatcher.h"
+
+#include <QHash>
+#include <QQueue>
+#include <QSet>
+#include <QVector>
+
+#include <KEmoticons>
+#include <KEmoticonsTheme>
+
+namespace Choqok
+{
+
+class EmoticonMatcher::Private
+{
+public:
+    struct Node {
+        Node()
+            : fail(0), pattern(-1), output(-1), depth(0)
+        {}
+        QHash<QChar, int> next;
+        int fail;    // Node of the longest proper suffix which is in trie
+        int pattern; // Emoticon ending at this node, or -1
+        int output;  // Nearest node with an emoticon on fail chain (this one included), or -1
+        int depth;
+    };
+
+    struct Emoticon {
+        QString text; // HTML escaped, as it appears on text
+        QString html;
+    };
+
+    Private()
+        : strict(false)
+    {
+        nodes.append(Node());
+    }
+
+    void add(const QString &text, const QString &html);
+    void compile();
+    QVector<int> longestMatches(const QString &text) const;
+
+    QVector<Node> nodes;
+    QVector<Emoticon> emoticons;
+    QSet<QString> texts;
+    QSet<QChar> firstChars; // Same as keys of KEmoticonsProvider::emoticonsIndex()
+    bool strict;
+};
+
+void EmoticonMatcher::Private::add(const QString &text, const QString &html)
+{
+    int node = 0;
+    for (const QChar c: text) {
+        int child = nodes.at(node).next.value(c, -1);
+        if (child == -1) {
+            child = nodes.count();
+            Node newNode;
+            newNode.depth = nodes.at(node).depth + 1;
+            nodes.append(newNode);
+            nodes[node].next.insert(c, child);
+        }
+        node = child;
+    }
+    Emoticon emoticon;
+    emoticon.text = text;
+    emoticon.html = html;
+    nodes[node].pattern = emoticons.count();
+    emoticons.append(emoticon);
+}
+
+void EmoticonMatcher::Private::compile()
+{
+    QQueue<int> queue;
+    for (const int child: nodes.at(0).next) {
+        nodes[child].fail = 0;
+        nodes[child].output = nodes.at(child).pattern == -1 ? -1 : child;
+        queue.enqueue(child);
+    }
+    while (!queue.isEmpty()) {
+        const int node = queue.dequeue();
+        for (auto it = nodes.at(node).next.constBegin(); it != nodes.at(node).next.constEnd(); ++it) {
+            const int child = it.value();
+            int fail = nodes.at(node).fail;
+            while (fail && !nodes.at(fail).next.contains(it.key())) {
+                fail = nodes.at(fail).fail;
+            }
+            fail = nodes.at(fail).next.value(it.key(), 0);
+            nodes[child].fail = fail;
+            nodes[child].output = nodes.at(child).pattern == -1 ? nodes.at(fail).output : child;
+            queue.enqueue(child);
+        }
+    }
+}
+
+QVector<int> EmoticonMatcher::Private::longestMatches(const QString &text) const
+{
+    QVector<int> matches(text.length(), -1);
+    int state = 0;
+    for (int i = 0; i < text.length(); ++i) {
+        const QChar c = text.at(i);
+        while (state && !nodes.at(state).next.contains(c)) {
+            state = nodes.at(state).fail;
+        }
+        state = nodes.at(state).next.value(c, 0);
+        for (int out = nodes.at(state).output; out != -1; out = nodes.at(nodes.at(out).fail).output) {
+            const Node &node = nodes.at(out);
+            int &match = matches[i + 1 - node.depth];
+            if (match == -1 || emoticons.at(match).text.length() < node.depth) {
+                match = node.pattern;
+            }
+        }
+    }
+    return matches;
+}
+
+EmoticonMatcher::EmoticonMatcher(const KEmoticonsTheme &theme, const QStringList &exclude)
+    : d(new Private)
+{
+    if (theme.isNull()) {
+        return;
+    }
+    d->strict = KEmoticons::parseMode().testFlag(KEmoticonsTheme::StrictParse);
+
+    const QHash<QString, QStringList> map = theme.emoticonsMap();
+    for (const QStringList &codes: map) {
+        for (const QString &code: codes) {
+            const QString escaped = code.toHtmlEscaped();
+            if (code.isEmpty() || d->texts.contains(escaped)) {
+                continue;
+            }
+            d->texts.insert(escaped);
+            d->firstChars.insert(code.at(0));
+            d->firstChars.insert(escaped.at(0));
+
+            // Let the theme generate image code, So it will be exactly the same
+            QString html = escaped;
+            if (!exclude.contains(escaped)) {
+                const QList<KEmoticonsTheme::Token> tokens = theme.tokenize(code, KEmoticonsTheme::RelaxedParse);
+                if (tokens.count() == 1 && tokens.first().type == KEmoticonsTheme::Image) {
+                    html = tokens.first().picHTMLCode;
+                }
+            }
+            d->add(escaped, html);
+        }
+    }
+    d->compile();
+}
+
+EmoticonMatcher::~EmoticonMatcher()
+{
+    delete d;
+}
+
+int EmoticonMatcher::count() const
+{
+    return d->emoticons.count();
+}
+
+QString EmoticonMatcher::parse(const QString &text) const
+{
+    if (d->emoticons.isEmpty() || text.isEmpty()) {
+        return text;
+    }
+    const QVector<int> matches = d->longestMatches(text);
+
+    // Same state machine as KEmoticonsTheme::tokenize() with SkipHTML, Only the lookup of emoticons differs
+    QString result;
+    int copied = 0;
+    QChar previous = QLatin1Char(' ');
+    bool inHtmlTag = false;
+    bool inHtmlLink = false;
+    bool inHtmlEntity = false;
+    for (int pos = 0; pos < text.length(); ++pos) {
+        const QChar c = text.at(pos);
+        if (!inHtmlTag) {
+            if (c == QLatin1Char('<')) {
+                inHtmlTag = true;
+                previous = c;
+                continue;
+            }
+        } else {
+            if (c == QLatin1Char('>')) {
+                inHtmlTag = false;
+                if (previous == QLatin1Char('a')) {
+                    inHtmlLink = false;
+                }
+            } else if (c == QLatin1Char('a') && previous == QLatin1Char('<')) {
+                inHtmlLink = true;
+            }
+            previous = c;
+            continue;
+        }
+        if (!inHtmlEntity && c == QLatin1Char('&')) {
+            inHtmlEntity = true;
+        }
+        if (inHtmlLink || (d->strict && !previous.isSpace() && previous != QLatin1Char('>'))) {
+            previous = c;
+            continue;
+        }
+        if (d->firstChars.contains(c)) {
+            bool found = false;
+            const int match = matches.at(pos);
+            if (match != -1) {
+                const Private::Emoticon &emoticon = d->emoticons.at(match);
+                const int end = pos + emoticon.text.length();
+                bool accepted = true;
+                if (d->strict && end < text.length()) {
+                    const QChar next = text.at(end);
+                    accepted = next == QLatin1Char('<') || next.isSpace() || next.isNull() || next == QLatin1Char('&');
+                }
+                if (accepted) {
+                    result += text.midRef(copied, pos - copied);
+                    result += emoticon.html;
+                    copied = end;
+                    pos = end - 1;
+                    found = true;
+                }
+            }
+            if (!found && inHtmlEntity) {
+                const int entityEnd = text.indexOf(QLatin1Char(';'), pos);
+                if (entityEnd == -1) {
+                    ++pos;
+                } else {
+                    pos = entityEnd;
+                }
+                inHtmlEntity = false;
+            }
+        }
+        previous = c;
+    }
+    if (copied == 0) {
+        return text;
+    }
+    result += text.midRef(copied);
+    return result;
+}
+
+}
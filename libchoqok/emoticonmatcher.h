@@ -0,0 +1,73 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+#ifndef EMOTICONMATCHER_H
+#define EMOTICONMATCHER_H
+
+#include <QString>
+#include <QStringList>
+
+#include "choqok_export.h"
+
+class KEmoticonsTheme;
+
+namespace Choqok
+{
+
+/**
+@brief Precompiled matcher of the emoticons of a theme
+
+All emoticon texts of the theme are compiled into one Aho-Corasick automaton, so @ref parse()
+finds the emoticons of a text in one pass, no matter how many emoticons the theme has.
+The result is the same as KEmoticonsTheme::parseEmoticons() with KEmoticonsTheme::DefaultParse.
+
+@Note parse() is thread safe
+@see MediaManager::emoticonMatcher()
+*/
+class CHOQOK_EXPORT EmoticonMatcher
+{
+public:
+    /**
+    Compile emoticons of @p theme, emoticons in @p exclude will be left as text
+    */
+    explicit EmoticonMatcher(const KEmoticonsTheme &theme, const QStringList &exclude = QStringList());
+    ~EmoticonMatcher();
+
+    /**
+    @return @p text with its emoticons replaced with their HTML image code
+    HTML tags and links of @p text are left untouched.
+    */
+    QString parse(const QString &text) const;
+
+    /**
+    @return Number of compiled emoticon texts
+    */
+    int count() const;
+
+private:
+    Q_DISABLE_COPY(EmoticonMatcher)
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif // EMOTICONMATCHER_H
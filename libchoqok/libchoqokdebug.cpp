@@ -19,4 +19,5 @@
 
 #include "libchoqokdebug.h"
 Q_LOGGING_CATEGORY(CHOQOK, "org.kde.choqok.lib")
+Q_LOGGING_CATEGORY(CHOQOK_PERF, "org.kde.choqok.lib.performance", QtWarningMsg)
 
@@ -22,6 +22,7 @@
 
 #include <QLoggingCategory>
 Q_DECLARE_LOGGING_CATEGORY(CHOQOK)
+Q_DECLARE_LOGGING_CATEGORY(CHOQOK_PERF)
 
 #endif
 
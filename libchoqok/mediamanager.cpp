@@ -23,43 +23,372 @@
 #include "mediamanager.h"
 
 #include <QApplication>
+#include <QBuffer>
+#include <QCache>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QHash>
 #include <QIcon>
-#include <QMimeDatabase>
+#include <QImageReader>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QPointer>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
 
 #include <KEmoticons>
 #include <KEmoticonsTheme>
 #include <KImageCache>
 #include <KIO/StoredTransferJob>
 #include <KLocalizedString>
-#include <KMessageBox>
 
 #include "choqokbehaviorsettings.h"
-#include "choqokuiglobal.h"
+#include "emoticonmatcher.h"
 #include "libchoqokdebug.h"
+#include "mediumreadjob.h"
 #include "pluginmanager.h"
 #include "uploader.h"
 
 namespace Choqok
 {
 
+static const int MaxConcurrentDecodes = 2;
+static const int MaxDownloads = 8;
+static const int MaxDownloadsPerHost = 3;
+
+// Freshness of cached images, Used when server doesn't tell or tells something unreasonable
+static const qint64 DefaultTimeToLive = 24 * 3600;
+static const qint64 MinTimeToLive = 3600;
+static const qint64 MaxTimeToLive = 30 * 24 * 3600;
+static const int SaveValidatorsDelay = 30000;
+
+// Header of validators file, Older files had none and are dropped
+static const quint32 ValidatorsMagic = 0x43485649; // CHVI
+static const quint32 ValidatorsVersion = 1;
+
+// Gray icons kept by grayScaleIcon(), Timelines use a handful of them
+static const int MaxGrayScaleIcons = 64;
+
+/**
+HTTP validators of a cached image
+*/
+struct ImageValidators {
+    ImageValidators()
+        : version(0)
+    {}
+    QByteArray etag;
+    QByteArray lastModified;
+    QDateTime expires;
+    qint64 version;     // Download time of cached image in msecs, Part of its cache keys. 0 for older caches
+};
+
+QDataStream &operator<<(QDataStream &out, const ImageValidators &validators)
+{
+    return out << validators.etag << validators.lastModified << validators.expires << validators.version;
+}
+
+QDataStream &operator>>(QDataStream &in, ImageValidators &validators)
+{
+    return in >> validators.etag >> validators.lastModified >> validators.expires >> validators.version;
+}
+
+class ImageDecodeTask : public QRunnable
+{
+public:
+    ImageDecodeTask(const QUrl &url, const QByteArray &data, const QSize &maxSize, MediaManager *manager)
+        : url(url), data(data), maxSize(maxSize), manager(manager)
+    {}
+
+    void run() override
+    {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader reader(&buffer);
+        reader.setAutoTransform(true);
+        const QSize size = reader.size();
+        QSize decodeSize;
+        if (maxSize.isValid() && size.isValid() &&
+                (size.width() > maxSize.width() || size.height() > maxSize.height())) {
+            // Most decoders (e.g. JPEG) skip the unneeded pixels, Instead of decoding all and scaling later
+            reader.setScaledSize(size.scaled(maxSize, Qt::KeepAspectRatio));
+            decodeSize = maxSize;
+        }
+        const QImage image = reader.read();
+        QMetaObject::invokeMethod(manager, "slotImageDecoded", Qt::QueuedConnection,
+                                  Q_ARG(QUrl, url), Q_ARG(QImage, image), Q_ARG(QSize, decodeSize));
+    }
+
+private:
+    QUrl url;
+    QByteArray data;
+    QSize maxSize;
+    MediaManager *manager;
+};
+
+struct ImageWaiter {
+    QPointer<QObject> receiver;
+    QByteArray member;
+    QByteArray errorMember;
+};
+
 class MediaManager::Private
 {
 public:
     Private()
-        : emoticons(KEmoticons().theme()), cache(QLatin1String("choqok-userimages"), 30000000), uploader(nullptr)
-    {}
+        : emoticons(KEmoticons().theme()), emoticonMatcher(nullptr), cache(QLatin1String("choqok-userimages"), 30000000),
+          hits(0), misses(0), evictions(0), uploader(nullptr)
+    {
+        decoders.setMaxThreadCount(MaxConcurrentDecodes);
+        saveTimer.setSingleShot(true);
+        saveTimer.setInterval(SaveValidatorsDelay);
+        loadValidators();
+    }
+    ~Private()
+    {
+        decoders.clear();
+        decoders.waitForDone();
+        if (saveTimer.isActive()) {
+            saveValidators();
+        }
+        delete emoticonMatcher;
+    }
     KEmoticonsTheme emoticons;
+    EmoticonMatcher *emoticonMatcher;
+    QMutex emoticonMatcherMutex;                 // Guards building emoticonMatcher, It's requested from worker threads
     KImageCache cache;
+    QCache<QString, QPixmap> pixmaps;            // <pixmapKey(), Pixmap> costs are in KiB
+    qint64 hits;
+    qint64 misses;
+    qint64 evictions;
     QHash<KJob *, QUrl> queue;
+    QHash<QUrl, KJob *> downloads;               // Reverse of queue
+    QHash<QString, int> hostDownloads;           // <Host, Count of running downloads>
+    QHash<QUrl, int> queued;                     // <Url waiting for a download slot, Priority>
+    QList<QUrl> downloadQueues[LowPriority + 1]; // Urls by priority, May have stale entries, See queued
+    QSet<QUrl> broadcasts;                       // Urls requested without a receiver, See imageFetched()
+    QSet<QUrl> pending;                          // Urls being queued, downloaded or decoded
+    QHash<QUrl, QList<ImageWaiter> > waiters;    // <Url on the way, Receivers>
+    QHash<QUrl, QSize> maxSizes;                 // <Url on the way, Largest size requested, invalid for original>
+    QThreadPool decoders;
+    QHash<QUrl, QByteArray> decoding;            // <Url being decoded, Downloaded data>, Kept for larger requests
+    QHash<QString, ImageValidators> validators; // <Url, Validators of cached image>
+    QSet<QUrl> revalidating;                    // Urls with a stale image on the cache, on the way
+    QTimer saveTimer;
     QPixmap defaultImage;
     Uploader *uploader;
+
+    QString cacheKey(const QUrl &url, const QSize &decodeSize = QSize()) const;
+    QString pixmapKey(const QUrl &url, int width = 0, const QSize &decodeSize = QSize()) const;
+    bool findPixmap(const QUrl &url, const QSize &maxSize, QPixmap *pixmap, bool *stale = nullptr);
+    bool hasReceivers(const QUrl &url) const;
+    void forget(const QUrl &url);
+    void insertPixmap(const QString &key, const QPixmap &pixmap);
+
+    static QString validatorsFileName();
+    void loadValidators();
+    void saveValidators();
+    void updateValidators(const QUrl &url, const QString &headers);
 };
 
+QString MediaManager::Private::validatorsFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/imagevalidators");
+}
+
+void MediaManager::Private::loadValidators()
+{
+    QFile file(validatorsFileName());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != ValidatorsMagic || version != ValidatorsVersion) {
+        // Cached images get a default life, See findPixmap()
+        return;
+    }
+    stream >> validators;
+
+    // Forget validators of images which should have been gone from cache anyway
+    const QDateTime oldest = QDateTime::currentDateTimeUtc().addSecs(-MaxTimeToLive);
+    for (auto it = validators.begin(); it != validators.end();) {
+        if (it.value().expires < oldest) {
+            it = validators.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MediaManager::Private::saveValidators()
+{
+    saveTimer.stop();
+    QDir().mkpath(QFileInfo(validatorsFileName()).absolutePath());
+    QSaveFile file(validatorsFileName());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(CHOQOK) << "Cannot save image validators to" << file.fileName();
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << ValidatorsMagic << ValidatorsVersion << validators;
+    file.commit();
+}
+
+void MediaManager::Private::updateValidators(const QUrl &url, const QString &headers)
+{
+    ImageValidators &entry = validators[url.toDisplayString()];
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    qint64 timeToLive = DefaultTimeToLive;
+    bool maxAgeFound = false;
+    for (const QString &line: headers.split(QLatin1Char('\n'))) {
+        const int colon = line.indexOf(QLatin1Char(':'));
+        if (colon == -1) {
+            continue;
+        }
+        const QString name = line.left(colon).trimmed().toLower();
+        const QString value = line.mid(colon + 1).trimmed();
+        if (name == QLatin1String("etag")) {
+            entry.etag = value.toLatin1();
+        } else if (name == QLatin1String("last-modified")) {
+            entry.lastModified = value.toLatin1();
+        } else if (name == QLatin1String("cache-control")) {
+            for (const QString &directive: value.split(QLatin1Char(','))) {
+                const QString token = directive.trimmed().toLower();
+                if (token.startsWith(QLatin1String("max-age="))) {
+                    timeToLive = token.mid(8).toLongLong();
+                    maxAgeFound = true;
+                }
+            }
+        } else if (name == QLatin1String("expires") && !maxAgeFound) {
+            const QDateTime expires = QDateTime::fromString(value, Qt::RFC2822Date);
+            if (expires.isValid()) {
+                timeToLive = now.secsTo(expires);
+            }
+        }
+    }
+    entry.expires = now.addSecs(qBound(MinTimeToLive, timeToLive, MaxTimeToLive));
+    saveTimer.start();
+}
+
+/**
+@return Key of @p url decoded to fit @p decodeSize on disk cache, Invalid size means the image as fetched
+Keys include the version of image, So a changed image makes all of its variants unreachable.
+*/
+QString MediaManager::Private::cacheKey(const QUrl &url, const QSize &decodeSize) const
+{
+    QString key = url.toDisplayString();
+    const qint64 version = validators.value(key).version;
+    if (version) {
+        key += QLatin1String(" v") + QString::number(version);
+    }
+    if (decodeSize.isValid()) {
+        key += QStringLiteral(" %1x%2").arg(decodeSize.width()).arg(decodeSize.height());
+    }
+    return key;
+}
+
+/**
+@return Key of @p url decoded to fit @p decodeSize and scaled to @p width on memory cache,
+0 means the image as decoded
+*/
+QString MediaManager::Private::pixmapKey(const QUrl &url, int width, const QSize &decodeSize) const
+{
+    return cacheKey(url, decodeSize) + QLatin1Char(' ') + QString::number(width);
+}
+
+bool MediaManager::Private::findPixmap(const QUrl &url, const QSize &maxSize, QPixmap *pixmap, bool *stale)
+{
+    // The image decoded to fit maxSize will do, And the one as fetched fits any size
+    QVector<QSize> decodeSizes;
+    if (maxSize.isValid()) {
+        decodeSizes.append(maxSize);
+    }
+    decodeSizes.append(QSize());
+
+    bool found = false;
+    for (const QSize &decodeSize: decodeSizes) {
+        if (QPixmap *cached = pixmaps.object(pixmapKey(url, 0, decodeSize))) {
+            *pixmap = *cached;
+            found = true;
+            break;
+        }
+    }
+    if (found) {
+        ++hits;
+    } else {
+        ++misses;
+        for (const QSize &decodeSize: decodeSizes) {
+            if (cache.findPixmap(cacheKey(url, decodeSize), pixmap)) {
+                insertPixmap(pixmapKey(url, 0, decodeSize), *pixmap);
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    if (stale) {
+        auto entry = validators.find(url.toDisplayString());
+        if (entry == validators.end()) {
+            // Cached before validators were kept, Give it a default life
+            validators[url.toDisplayString()].expires = QDateTime::currentDateTimeUtc().addSecs(DefaultTimeToLive);
+            saveTimer.start();
+            *stale = false;
+        } else {
+            *stale = entry.value().expires < QDateTime::currentDateTimeUtc();
+        }
+    }
+    return true;
+}
+
+bool MediaManager::Private::hasReceivers(const QUrl &url) const
+{
+    for (const ImageWaiter &waiter: waiters.value(url)) {
+        if (waiter.receiver) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MediaManager::Private::forget(const QUrl &url)
+{
+    pending.remove(url);
+    revalidating.remove(url);
+    maxSizes.remove(url);
+    decoding.remove(url);
+    waiters.remove(url);
+    broadcasts.remove(url);
+}
+
+void MediaManager::Private::insertPixmap(const QString &key, const QPixmap &pixmap)
+{
+    const int cost = qMax<qint64>(1, qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8 / 1024);
+    const int others = pixmaps.count() - (pixmaps.contains(key) ? 1 : 0);
+    pixmaps.insert(key, new QPixmap(pixmap), cost);
+    evictions += qMax(0, others + 1 - pixmaps.count());
+}
+
 MediaManager::MediaManager()
     : QObject(qApp), d(new Private)
 {
     d->defaultImage = QIcon::fromTheme(QLatin1String("image-loading")).pixmap(48);
+    slotConfigChanged();
+    connect(BehaviorSettings::self(), &BehaviorSettings::configChanged, this, &MediaManager::slotConfigChanged);
+    connect(&d->saveTimer, &QTimer::timeout, this, &MediaManager::slotSaveValidators);
 }
 
 MediaManager::~MediaManager()
@@ -85,80 +414,365 @@ QPixmap &MediaManager::defaultImage()
 
 QString MediaManager::parseEmoticons(const QString &text)
 {
-    return d->emoticons.parseEmoticons(text, KEmoticonsTheme::DefaultParse, QStringList() << QLatin1String("(e)"));
+    return emoticonMatcher()->parse(text);
+}
+
+const EmoticonMatcher *MediaManager::emoticonMatcher()
+{
+    QMutexLocker locker(&d->emoticonMatcherMutex);
+    if (!d->emoticonMatcher) {
+        d->emoticonMatcher = new EmoticonMatcher(d->emoticons, QStringList() << QLatin1String("(e)"));
+    }
+    return d->emoticonMatcher;
 }
 
 QPixmap MediaManager::fetchImage(const QUrl &remoteUrl, ReturnMode mode /*= Sync*/)
 {
     QPixmap p;
-    if (d->cache.findPixmap(remoteUrl.toDisplayString(), &p)) {
+    bool stale = false;
+    if (d->findPixmap(remoteUrl, QSize(), &p, &stale)) {
         Q_EMIT imageFetched(remoteUrl, p);
-    } else if (mode == Async) {
-        if (d->queue.values().contains(remoteUrl)) {
-            ///The file is on the way, wait to download complete.
-            return p;
+        if (stale && mode == Async) {
+            d->broadcasts.insert(remoteUrl);
+            startImageJob(remoteUrl, QSize(), true, NormalPriority);
         }
-        KIO::StoredTransferJob *job = KIO::storedGet(remoteUrl, KIO::NoReload, KIO::HideProgressInfo) ;
-        if (!job) {
-            qCCritical(CHOQOK) << "Cannot create a FileCopyJob!";
-            QString errMsg = i18n("Cannot create a KDE Job. Please check your installation.");
-            Q_EMIT fetchError(remoteUrl, errMsg);
-            return p;
+    } else if (mode == Async) {
+        d->broadcasts.insert(remoteUrl);
+        startImageJob(remoteUrl, QSize(), false, NormalPriority);
+    }
+    return p;
+}
+
+QPixmap MediaManager::fetchImage(const QUrl &remoteUrl, QObject *receiver, const char *member,
+                                 const char *errorMember, const QSize &maxSize, FetchPriority priority)
+{
+    QPixmap p;
+    bool stale = false;
+    if (d->findPixmap(remoteUrl, maxSize, &p, &stale) && !stale) {
+        return p;
+    }
+    // A stale image is shown meanwhile, Receiver will be called only if it's changed on server
+    ImageWaiter waiter;
+    waiter.receiver = receiver;
+    waiter.member = member;
+    waiter.errorMember = errorMember;
+    QList<ImageWaiter> &waiters = d->waiters[remoteUrl];
+    bool waiting = false;
+    for (const ImageWaiter &w: waiters) {
+        if (w.receiver == receiver && w.member == waiter.member) {
+            waiting = true;
+            break;
         }
-        d->queue.insert(job, remoteUrl);
-        connect(job, &KIO::StoredTransferJob::result, this, &MediaManager::slotImageFetched);
-        job->start();
     }
+    if (!waiting) {
+        waiters.append(waiter);
+    }
+    startImageJob(remoteUrl, maxSize, stale, priority);
     return p;
 }
 
+void MediaManager::setImageFetchPriority(const QUrl &remoteUrl, FetchPriority priority)
+{
+    auto it = d->queued.find(remoteUrl);
+    if (it != d->queued.end() && priority < it.value()) {
+        it.value() = priority;
+        d->downloadQueues[priority].append(remoteUrl);
+    }
+}
+
+void MediaManager::cancelImageFetch(const QUrl &remoteUrl, QObject *receiver)
+{
+    auto it = d->waiters.find(remoteUrl);
+    if (it == d->waiters.end()) {
+        return;
+    }
+    QList<ImageWaiter> &waiters = it.value();
+    for (int i = waiters.count() - 1; i >= 0; --i) {
+        if (!waiters.at(i).receiver || waiters.at(i).receiver == receiver) {
+            waiters.removeAt(i);
+        }
+    }
+    if (d->hasReceivers(remoteUrl) || d->broadcasts.contains(remoteUrl)) {
+        return;
+    }
+    // Nobody wants it anymore
+    if (d->queued.remove(remoteUrl)) {
+        d->forget(remoteUrl);
+    } else if (KJob *job = d->downloads.value(remoteUrl)) {
+        finishDownload(job);
+        job->kill();
+        d->forget(remoteUrl);
+        startDownloads();
+    }
+}
+
+void MediaManager::startImageJob(const QUrl &remoteUrl, const QSize &maxSize, bool revalidate,
+                                 FetchPriority priority)
+{
+    auto size = d->maxSizes.find(remoteUrl);
+    if (size == d->maxSizes.end()) {
+        d->maxSizes.insert(remoteUrl, maxSize);
+    } else if (size.value().isValid()) {
+        size.value() = maxSize.isValid() ? size.value().expandedTo(maxSize) : QSize();
+    }
+    if (d->pending.contains(remoteUrl)) {
+        ///The file is on the way, wait to download complete.
+        setImageFetchPriority(remoteUrl, priority);
+        return;
+    }
+    d->pending.insert(remoteUrl);
+    if (revalidate) {
+        d->revalidating.insert(remoteUrl);
+    }
+    d->queued.insert(remoteUrl, priority);
+    d->downloadQueues[priority].append(remoteUrl);
+    startDownloads();
+}
+
+void MediaManager::startDownloads()
+{
+    for (int priority = HighPriority; priority <= LowPriority; ++priority) {
+        QList<QUrl> &queue = d->downloadQueues[priority];
+        int i = 0;
+        while (i < queue.count() && d->downloads.count() < MaxDownloads) {
+            const QUrl url = queue.at(i);
+            auto it = d->queued.find(url);
+            if (it == d->queued.end() || it.value() != priority) {
+                // Started, cancelled or moved to a higher priority
+                queue.removeAt(i);
+                continue;
+            }
+            if (!d->hasReceivers(url) && !d->broadcasts.contains(url)) {
+                // All receivers are closed meanwhile
+                d->queued.erase(it);
+                queue.removeAt(i);
+                d->forget(url);
+                continue;
+            }
+            if (d->hostDownloads.value(url.host()) >= MaxDownloadsPerHost) {
+                ++i;
+                continue;
+            }
+            d->queued.erase(it);
+            queue.removeAt(i);
+            startDownload(url);
+        }
+    }
+}
+
+void MediaManager::startDownload(const QUrl &remoteUrl)
+{
+    const bool revalidate = d->revalidating.contains(remoteUrl);
+    KIO::StoredTransferJob *job = KIO::storedGet(remoteUrl, revalidate ? KIO::Reload : KIO::NoReload,
+                                                 KIO::HideProgressInfo) ;
+    if (!job) {
+        qCCritical(CHOQOK) << "Cannot create a FileCopyJob!";
+        QString errMsg = i18n("Cannot create a KDE Job. Please check your installation.");
+        deliverFetchError(remoteUrl, errMsg);
+        return;
+    }
+    job->addMetaData(QStringLiteral("PropagateHttpHeader"), QStringLiteral("true"));
+    if (revalidate) {
+        // Conditional request, Server replies 304 if our copy is still valid
+        const ImageValidators validators = d->validators.value(remoteUrl.toDisplayString());
+        QStringList headers;
+        if (!validators.etag.isEmpty()) {
+            headers << QLatin1String("If-None-Match: ") + QLatin1String(validators.etag);
+        }
+        if (!validators.lastModified.isEmpty()) {
+            headers << QLatin1String("If-Modified-Since: ") + QLatin1String(validators.lastModified);
+        }
+        if (!headers.isEmpty()) {
+            job->addMetaData(QStringLiteral("customHTTPHeader"), headers.join(QLatin1String("\r\n")));
+        }
+    }
+    d->queue.insert(job, remoteUrl);
+    d->downloads.insert(remoteUrl, job);
+    ++d->hostDownloads[remoteUrl.host()];
+    connect(job, &KIO::StoredTransferJob::result, this, &MediaManager::slotImageFetched);
+    job->start();
+}
+
+QUrl MediaManager::finishDownload(KJob *job)
+{
+    const QUrl remote = d->queue.take(job);
+    d->downloads.remove(remote);
+    auto host = d->hostDownloads.find(remote.host());
+    if (host != d->hostDownloads.end() && --host.value() <= 0) {
+        d->hostDownloads.erase(host);
+    }
+    return remote;
+}
+
+void MediaManager::deliverImage(const QUrl &remoteUrl, const QPixmap &pixmap)
+{
+    const QList<ImageWaiter> waiters = d->waiters.take(remoteUrl);
+    d->forget(remoteUrl);
+    for (const ImageWaiter &waiter: waiters) {
+        if (waiter.receiver) {
+            QMetaObject::invokeMethod(waiter.receiver, waiter.member.constData(),
+                                      Q_ARG(QUrl, remoteUrl), Q_ARG(QPixmap, pixmap));
+        }
+    }
+    Q_EMIT imageFetched(remoteUrl, pixmap);
+}
+
+void MediaManager::deliverFetchError(const QUrl &remoteUrl, const QString &errMsg)
+{
+    const QList<ImageWaiter> waiters = d->waiters.take(remoteUrl);
+    d->forget(remoteUrl);
+    for (const ImageWaiter &waiter: waiters) {
+        if (waiter.receiver && !waiter.errorMember.isEmpty()) {
+            QMetaObject::invokeMethod(waiter.receiver, waiter.errorMember.constData(),
+                                      Q_ARG(QUrl, remoteUrl), Q_ARG(QString, errMsg));
+        }
+    }
+    Q_EMIT fetchError(remoteUrl, errMsg);
+}
+
 void MediaManager::slotImageFetched(KJob *job)
 {
     KIO::StoredTransferJob *baseJob = qobject_cast<KIO::StoredTransferJob *>(job);
-    QUrl remote = d->queue.value(job);
-    d->queue.remove(job);
+    QUrl remote = finishDownload(job);
+    startDownloads();
 
     int responseCode = 0;
     if (baseJob->metaData().contains(QStringLiteral("responsecode"))) {
         responseCode = baseJob->queryMetaData(QStringLiteral("responsecode")).toInt();
     }
 
+    if (d->revalidating.contains(remote) && (responseCode == 304 || job->error() || responseCode > 399)) {
+        // Keep showing the cached image, On error try again later
+        if (responseCode == 304) {
+            d->updateValidators(remote, baseJob->queryMetaData(QStringLiteral("HTTP-Headers")));
+        } else {
+            qCDebug(CHOQOK) << "Cannot revalidate" << remote << job->errorString();
+            d->validators[remote.toDisplayString()].expires = QDateTime::currentDateTimeUtc().addSecs(MinTimeToLive);
+            d->saveTimer.start();
+        }
+        d->forget(remote);
+        return;
+    }
+
     if (job->error() || (responseCode > 399 && responseCode < 600)) {
         qCCritical(CHOQOK) << "Job error:" << job->error() << "\t" << job->errorString();
         qCCritical(CHOQOK) << "HTTP response code" << responseCode;
         QString errMsg = i18n("Cannot download image from %1.", job->errorString());
-        Q_EMIT fetchError(remote, errMsg);
+        deliverFetchError(remote, errMsg);
     } else {
-        QPixmap p;
-        if (p.loadFromData(baseJob->data())) {
-            d->cache.insertPixmap(remote.toDisplayString(), p);
-            Q_EMIT imageFetched(remote, p);
-        } else {
-            qCCritical(CHOQOK) << "Cannot parse reply from " << baseJob->url().toDisplayString();
-            Q_EMIT fetchError(remote, i18n("The request failed. Cannot get image file."));
-        }
+        d->updateValidators(remote, baseJob->queryMetaData(QStringLiteral("HTTP-Headers")));
+        // A new version, Variants of older ones (other decode sizes, scaled copies) are not found anymore
+        d->validators[remote.toDisplayString()].version = QDateTime::currentMSecsSinceEpoch();
+        d->saveTimer.start();
+        d->decoding.insert(remote, baseJob->data());
+        d->decoders.start(new ImageDecodeTask(remote, baseJob->data(), d->maxSizes.value(remote), this));
+    }
+}
+
+void MediaManager::slotImageDecoded(const QUrl &remoteUrl, const QImage &image, const QSize &decodeSize)
+{
+    if (image.isNull()) {
+        qCCritical(CHOQOK) << "Cannot parse reply from " << remoteUrl.toDisplayString();
+        deliverFetchError(remoteUrl, i18n("The request failed. Cannot get image file."));
+        return;
+    }
+    const QPixmap p = QPixmap::fromImage(image);
+    // A downscaled image must not stand for the one as fetched, Of which other receivers may want all pixels
+    d->cache.insertPixmap(d->cacheKey(remoteUrl, decodeSize), p);
+    d->insertPixmap(d->pixmapKey(remoteUrl, 0, decodeSize), p);
+    const QSize wanted = d->maxSizes.value(remoteUrl);
+    if (decodeSize.isValid() && (!wanted.isValid() || wanted.expandedTo(decodeSize) != decodeSize) &&
+            d->decoding.contains(remoteUrl)) {
+        // Someone asked for a larger size while it was decoded, Waiters get the larger one
+        d->decoders.start(new ImageDecodeTask(remoteUrl, d->decoding.value(remoteUrl), wanted, this));
+        return;
+    }
+    deliverImage(remoteUrl, p);
+}
+
+QPixmap MediaManager::scaledImage(const QUrl &remoteUrl, const QPixmap &pixmap, int width)
+{
+    const QString key = d->pixmapKey(remoteUrl, width);
+    if (QPixmap *cached = d->pixmaps.object(key)) {
+        ++d->hits;
+        return *cached;
     }
+    ++d->misses;
+    const QPixmap scaled = pixmap.scaledToWidth(width, Qt::SmoothTransformation);
+    d->insertPixmap(key, scaled);
+    return scaled;
+}
+
+qint64 MediaManager::imageCacheHits() const
+{
+    return d->hits;
+}
+
+qint64 MediaManager::imageCacheMisses() const
+{
+    return d->misses;
+}
+
+qint64 MediaManager::imageCacheEvictions() const
+{
+    return d->evictions;
+}
+
+void MediaManager::slotSaveValidators()
+{
+    d->saveValidators();
+}
+
+void MediaManager::slotConfigChanged()
+{
+    d->pixmaps.setMaxCost(qMax(1, BehaviorSettings::imageMemoryCacheSize()) * 1024);
 }
 
 void MediaManager::clearImageCache()
 {
     d->cache.clear();
+    d->pixmaps.clear();
+    d->validators.clear();
+    d->saveTimer.start();
+}
+
+/**
+Same weights as qGray(), Simple enough for compilers to vectorize.
+Works on premultiplied pixels too, Since a premultiplied gray is the gray of premultiplied channels.
+*/
+static void convertLineToGrayScale(QRgb *line, int width)
+{
+    for (int x = 0; x < width; ++x) {
+        const QRgb pixel = line[x];
+        const uint gray = (((pixel >> 16) & 0xff) * 11 + ((pixel >> 8) & 0xff) * 16 + (pixel & 0xff) * 5) >> 5;
+        line[x] = (pixel & 0xff000000) | (gray << 16) | (gray << 8) | gray;
+    }
 }
 
 QPixmap MediaManager::convertToGrayScale(const QPixmap &pic)
 {
-    QImage result = pic.toImage();
+    QImage result = pic.toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const int width = result.width();
     for (int y = 0; y < result.height(); ++y) {
-        for (int x = 0; x < result.width(); ++x) {
-            int pixel = result.pixel(x, y);
-            int gray = qGray(pixel);
-            int alpha = qAlpha(pixel);
-            result.setPixel(x, y, qRgba(gray, gray, gray, alpha));
-        }
+        convertLineToGrayScale(reinterpret_cast<QRgb *>(result.scanLine(y)), width);
     }
     return QPixmap::fromImage(result);
 }
 
+QPixmap MediaManager::grayScaleIcon(const QString &iconName, int size)
+{
+    // Theme icons are cached by Qt, So a changed theme gives icons with new keys and old ones age out
+    static QCache<QPair<qint64, int>, QPixmap> icons(MaxGrayScaleIcons); // <Icon key and size, Gray icon>
+    const QIcon icon = QIcon::fromTheme(iconName);
+    const QPair<qint64, int> key(icon.cacheKey(), size);
+    if (QPixmap *cached = icons.object(key)) {
+        return *cached;
+    }
+    const QPixmap gray = convertToGrayScale(icon.pixmap(size));
+    icons.insert(key, new QPixmap(gray));
+    return gray;
+}
+
 void MediaManager::uploadMedium(const QUrl &localUrl, const QString &pluginId)
 {
     QString pId = pluginId;
@@ -181,60 +795,27 @@ void MediaManager::uploadMedium(const QUrl &localUrl, const QString &pluginId)
     if (!d->uploader) {
         return;
     }
-    KIO::StoredTransferJob *picJob = KIO::storedGet(localUrl, KIO::Reload, KIO::HideProgressInfo);
-    picJob->exec();
-    if (picJob->error()) {
-        qCritical() << "Job error:" << picJob->errorString();
-        KMessageBox::detailedError(UI::Global::mainWindow(), i18n("Uploading medium failed: cannot read the medium file."),
-                                   picJob->errorString());
-        return;
-    }
-    const QByteArray picData = picJob->data();
-    if (picData.count() == 0) {
-        qCritical() << "Cannot read the media file, please check if it exists.";
-        KMessageBox::error(UI::Global::mainWindow(), i18n("Uploading medium failed: cannot read the medium file."));
-        return;
-    }
-    connect(d->uploader, &Uploader::mediumUploaded, this, &MediaManager::mediumUploaded);
-    connect(d->uploader, &Uploader::uploadingFailed, this, &MediaManager::mediumUploadFailed);
-    const QMimeDatabase db;
-    d->uploader->upload(localUrl, picData, db.mimeTypeForUrl(localUrl).name().toLocal8Bit());
+    connect(d->uploader, &Uploader::mediumUploaded, this, &MediaManager::mediumUploaded, Qt::UniqueConnection);
+    connect(d->uploader, &Uploader::uploadingFailed, this, &MediaManager::mediumUploadFailed, Qt::UniqueConnection);
+    connect(d->uploader, &Uploader::uploadingProgress, this, &MediaManager::mediumUploadProgress, Qt::UniqueConnection);
+    MediumReadJob *job = new MediumReadJob(localUrl, this);
+    connect(job, &KJob::result, this, &MediaManager::slotMediumRead);
+    job->start();
 }
 
-QByteArray MediaManager::createMultipartFormData(const QMap< QString, QByteArray > &formdata,
-        const QList< QMap< QString, QByteArray > > &mediaFiles)
+void MediaManager::slotMediumRead(KJob *job)
 {
-    QByteArray newLine("\r\n");
-    QString formHeader(QLatin1String(newLine) + QLatin1String("Content-Disposition: form-data; name=\"%1\""));
-    QByteArray header("--AaB03x");
-    QByteArray footer("--AaB03x--");
-    QString fileHeader(QLatin1String(newLine) + QLatin1String("Content-Disposition: file; name=\"%1\"; filename=\"%2\""));
-    QByteArray data;
-
-    data.append(header);
-
-    if (!mediaFiles.isEmpty()) {
-        QList< QMap< QString, QByteArray > >::const_iterator it1 = mediaFiles.constBegin();
-        QList< QMap< QString, QByteArray > >::const_iterator endIt1 = mediaFiles.constEnd();
-        for (; it1 != endIt1; ++it1) {
-            data.append(fileHeader.arg(QLatin1String(it1->value(QLatin1String("name")).data())).arg(QLatin1String(it1->value(QLatin1String("filename")).data())).toUtf8());
-            data.append(newLine + "Content-Type: " + it1->value(QLatin1String("mediumType")));
-            data.append(newLine);
-            data.append(newLine + it1->value(QLatin1String("medium")));
-        }
+    MediumReadJob *readJob = qobject_cast<MediumReadJob *>(job);
+    if (job->error()) {
+        Q_EMIT mediumUploadFailed(readJob->url(), i18n("Cannot read the medium file: %1", job->errorString()));
+        return;
     }
-
-    for (const QString &key: formdata.keys()) {
-        data.append(newLine);
-        data.append(header);
-        data.append(formHeader.arg(key).toLatin1());
-        data.append(newLine);
-        data.append(newLine + formdata.value(key));
+    if (!d->uploader) {
+        Q_EMIT mediumUploadFailed(readJob->url(), i18n("The uploader plugin is not loaded anymore."));
+        return;
     }
-    data.append(newLine);
-    data.append(footer);
-
-    return data;
+    // Data of mapped files is only valid until the job is gone, upload() must not keep it
+    d->uploader->upload(readJob->url(), readJob->data(), readJob->mimeType());
 }
 
 }
@@ -37,10 +37,16 @@ class Job;
 class KJob;
 namespace Choqok
 {
+class EmoticonMatcher;
+
 /**
     @brief Media files manager!
     A simple and global way to fetch and cache images
 
+    Images are cached on disk, and the recently used ones also as shared pixmaps in memory.
+    HTTP validators (ETag, Last-Modified) and freshness of cached images are kept, An expired image is
+    still returned while it's revalidated with a conditional request in background.
+
     @author Mehrdad Momeny \<mehrdad.momeny@gmail.com\>
 */
 class CHOQOK_EXPORT MediaManager : public QObject
@@ -50,6 +56,15 @@ public:
     enum ReturnMode {
         Sync = 0, Async
     };
+
+    /**
+     * Order of downloads, Lower values start first
+     */
+    enum FetchPriority {
+        HighPriority = 0, ///< e.g. Posts on screen
+        NormalPriority,   ///< e.g. Posts of the current timeline
+        LowPriority       ///< e.g. Posts of background timelines, prefetching
+    };
     ~MediaManager();
 
     static MediaManager *self();
@@ -68,6 +83,54 @@ public:
      */
     QPixmap fetchImage(const QUrl &remoteUrl, ReturnMode mode = Sync);
 
+    /**
+     * @brief Fetch an Image for @p receiver only.
+     *
+     * If the image is not available in the cache, it will be fetched and @p member of @p receiver
+     * will be invoked with (const QUrl &remoteUrl, const QPixmap &pixmap) when it's ready,
+     * or @p errorMember (if any) with (const QUrl &remoteUrl, const QString &errMsg) on error.
+     * Only receivers waiting for @p remoteUrl are called, and each of them once.
+     * Downloads are queued by @p priority, with a limit on running downloads in total and per host.
+     * A queued or running download is cancelled when all of its receivers are destroyed or cancelled.
+     * Members must be slots or invokable methods.
+     * A valid @p maxSize lets the image be decoded at a smaller size, which is much faster for large photos.
+     * The cached image will be the largest requested by receivers of a download,
+     * It's kept apart from the image as fetched, Which is used for any @p maxSize if cached.
+     *
+     * @return return @ref QPixmap of requested image if exists in cache, Receiver will not be called then,
+     * Unless the image is expired and changed on server.
+     * @see cancelImageFetch()
+     */
+    QPixmap fetchImage(const QUrl &remoteUrl, QObject *receiver, const char *member,
+                       const char *errorMember = nullptr, const QSize &maxSize = QSize(),
+                       FetchPriority priority = NormalPriority);
+
+    /**
+     * @brief Raise priority of @p remoteUrl if it's still waiting for a download slot
+     */
+    void setImageFetchPriority(const QUrl &remoteUrl, FetchPriority priority);
+
+    /**
+     * @brief Stop delivering @p remoteUrl to @p receiver
+     * The download is cancelled if nobody else is waiting for it.
+     */
+    void cancelImageFetch(const QUrl &remoteUrl, QObject *receiver);
+
+    /**
+     * @return @p pixmap of @p remoteUrl scaled to @p width
+     * Scaled images are kept on the memory cache with the fetched ones, So widgets showing the same
+     * image at the same size share one pixmap.
+     */
+    QPixmap scaledImage(const QUrl &remoteUrl, const QPixmap &pixmap, int width);
+
+    /**
+     * Statistics of memory cache of images, Its size is BehaviorSettings::imageMemoryCacheSize() MiB
+     * A miss of fetched images may still be served from the disk cache.
+     */
+    qint64 imageCacheHits() const;
+    qint64 imageCacheMisses() const;
+    qint64 imageCacheEvictions() const;
+
     /**
      * @return KDE Default image
      */
@@ -78,34 +141,30 @@ public:
      */
     QString parseEmoticons(const QString &text);
 
+    /**
+     * @return Compiled emoticons of kde default theme, Built on first use.
+     * It's thread safe to use, e.g. for previews prepared on worker threads.
+     */
+    const EmoticonMatcher *emoticonMatcher();
+
     static QPixmap convertToGrayScale(const QPixmap &pic);
 
+    /**
+     * @return Gray scale version of theme icon @p iconName at @p size, Converted once and cached.
+     * Only the recently used ones are kept, Keyed by the icon so a theme change converts them again.
+     */
+    static QPixmap grayScaleIcon(const QString &iconName, int size);
+
     /**
     Upload medium at @p localUrl to @p pluginId service or to last used service when @p pluginId is empty.
+    The medium is read asynchronously, local files are memory mapped rather than copied.
 
     @see mediumUploaded()
     @see mediumUploadFailed()
+    @see mediumUploadProgress()
     */
     void uploadMedium(const QUrl &localUrl, const QString &pluginId = QString());
 
-    /**
-    Create and return a byte array containing a multipart/form-data to send with HTTP POST request
-
-    Boundary is AaB03x
-
-    @param formdata are the "form-data" parts of data.
-                    This map knows as a list of name/value pairs
-    @param mediaFiles are media files attached to form, each file stored in one QMap in list
-
-    @note media file maps should contain these keys:
-        name: The name of entry
-        filename: the file name on server
-        medium: contain the medium data loaded from disk!
-        mediumType: type of medium file
-    */
-    static QByteArray createMultipartFormData(const QMap<QString, QByteArray> &formdata,
-            const QList< QMap<QString, QByteArray> > &mediaFiles);
-
 public Q_SLOTS:
     /**
      * @brief Clear image cache
@@ -118,14 +177,26 @@ Q_SIGNALS:
 
     void mediumUploaded(const QUrl &localUrl, const QString &remoteUrl);
     void mediumUploadFailed(const QUrl &localUrl, const QString &errorMessage);
+    void mediumUploadProgress(const QUrl &localUrl, int percent);
 
 protected Q_SLOTS:
     void slotImageFetched(KJob *job);
+    void slotImageDecoded(const QUrl &remoteUrl, const QImage &image, const QSize &decodeSize);
+    void slotConfigChanged();
+    void slotSaveValidators();
+    void slotMediumRead(KJob *job);
 
 protected:
     MediaManager();
 
 private:
+    void startImageJob(const QUrl &remoteUrl, const QSize &maxSize, bool revalidate, FetchPriority priority);
+    void startDownloads();
+    void startDownload(const QUrl &remoteUrl);
+    QUrl finishDownload(KJob *job);
+    void deliverImage(const QUrl &remoteUrl, const QPixmap &pixmap);
+    void deliverFetchError(const QUrl &remoteUrl, const QString &errMsg);
+
     class Private;
     Private *const d;
     static MediaManager *mSelf;
@@ -0,0 +1,144 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+
+#include "mediumreadjob.h"
+
+#include <QFile>
+#include <QMimeDatabase>
+#include <QPointer>
+#include <QTimer>
+
+#include <KIO/StoredTransferJob>
+#include <KLocalizedString>
+
+#include "libchoqokdebug.h"
+
+namespace Choqok
+{
+
+class MediumReadJob::Private
+{
+public:
+    QUrl url;
+    QFile file;
+    QByteArray data;
+    QPointer<KIO::StoredTransferJob> remoteJob;
+};
+
+MediumReadJob::MediumReadJob(const QUrl &url, QObject *parent)
+    : KJob(parent), d(new Private)
+{
+    d->url = url;
+}
+
+MediumReadJob::~MediumReadJob()
+{
+    // Drop our reference before the file, And so its mapping, goes away
+    d->data.clear();
+    delete d;
+}
+
+void MediumReadJob::start()
+{
+    if (d->url.isLocalFile()) {
+        QTimer::singleShot(0, this, &MediumReadJob::slotReadLocalFile);
+    } else {
+        d->remoteJob = KIO::storedGet(d->url, KIO::Reload, KIO::HideProgressInfo);
+        connect(d->remoteJob.data(), &KIO::StoredTransferJob::result, this, &MediumReadJob::slotRemoteFileRead);
+        connect(d->remoteJob.data(), &KJob::percent, this, [this](KJob *, unsigned long percent) {
+            setPercent(percent);
+        });
+        d->remoteJob->start();
+    }
+}
+
+QUrl MediumReadJob::url() const
+{
+    return d->url;
+}
+
+QByteArray MediumReadJob::data() const
+{
+    return d->data;
+}
+
+QByteArray MediumReadJob::mimeType() const
+{
+    const QMimeDatabase db;
+    return db.mimeTypeForUrl(d->url).name().toUtf8();
+}
+
+bool MediumReadJob::doKill()
+{
+    if (d->remoteJob) {
+        d->remoteJob->kill(KJob::Quietly);
+    }
+    return true;
+}
+
+void MediumReadJob::slotReadLocalFile()
+{
+    if (error()) {  // Killed
+        return;
+    }
+    d->file.setFileName(d->url.toLocalFile());
+    if (!d->file.open(QIODevice::ReadOnly)) {
+        qCCritical(CHOQOK) << "Cannot open" << d->file.fileName() << d->file.errorString();
+        setError(KJob::UserDefinedError);
+        setErrorText(d->file.errorString());
+        emitResult();
+        return;
+    }
+    const qint64 size = d->file.size();
+    uchar *mapped = size > 0 ? d->file.map(0, size) : nullptr;
+    if (mapped) {
+        d->data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), size);
+    } else {
+        // Not mappable, e.g. a pipe
+        d->data = d->file.readAll();
+    }
+    if (d->data.isEmpty()) {
+        qCCritical(CHOQOK) << "Cannot read the media file, please check if it exists.";
+        setError(KJob::UserDefinedError);
+        setErrorText(i18n("The medium file is empty."));
+    }
+    setPercent(100);
+    emitResult();
+}
+
+void MediumReadJob::slotRemoteFileRead(KJob *job)
+{
+    if (job->error()) {
+        qCCritical(CHOQOK) << "Job error:" << job->errorString();
+        setError(job->error());
+        setErrorText(job->errorString());
+    } else {
+        d->data = qobject_cast<KIO::StoredTransferJob *>(job)->data();
+        if (d->data.isEmpty()) {
+            setError(KJob::UserDefinedError);
+            setErrorText(i18n("The medium file is empty."));
+        }
+    }
+    emitResult();
+}
+
+}
@@ -0,0 +1,81 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+
+#ifndef MEDIUMREADJOB_H
+#define MEDIUMREADJOB_H
+
+#include <QByteArray>
+#include <QUrl>
+
+#include <KJob>
+
+#include "choqok_export.h"
+
+namespace Choqok
+{
+
+/**
+@brief Reads a medium to upload without blocking the event loop
+
+Local files are memory mapped, So reading does not copy the file and its pages are only loaded
+when they are sent. Other URLs are fetched with an asynchronous KIO job.
+Progress is reported with the usual KJob signals.
+
+@see MediaManager::uploadMedium()
+*/
+class CHOQOK_EXPORT MediumReadJob : public KJob
+{
+    Q_OBJECT
+public:
+    explicit MediumReadJob(const QUrl &url, QObject *parent = nullptr);
+    ~MediumReadJob();
+
+    virtual void start() override;
+
+    QUrl url() const;
+
+    /**
+    @return Content of the medium
+    For local files it refers to the mapped file, And is valid only as long as this job exists.
+    */
+    QByteArray data() const;
+
+    /**
+    @return Mime type of the medium, Detected from its name
+    */
+    QByteArray mimeType() const;
+
+protected:
+    virtual bool doKill() override;
+
+private Q_SLOTS:
+    void slotReadLocalFile();
+    void slotRemoteFileRead(KJob *job);
+
+private:
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif // MEDIUMREADJOB_H
@@ -22,18 +22,32 @@
 
 #include "microblog.h"
 
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
 #include <QMenu>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QThreadPool>
 #include <QTimer>
 
+#include <algorithm>
+#include <iterator>
+
+#include <KConfig>
+#include <KConfigGroup>
 #include <KLocalizedString>
 
 #include "account.h"
 #include "accountmanager.h"
+#include "application.h"
 #include "choqokbehaviorsettings.h"
 #include "composerwidget.h"
 #include "libchoqokdebug.h"
 #include "microblogwidget.h"
+#include "poststore.h"
 #include "postwidget.h"
+#include "searchindex.h"
 #include "timelinewidget.h"
 
 namespace Choqok
@@ -45,6 +59,74 @@ public:
     QString homepage;
     QStringList timelineTypes;
     QTimer *saveTimelinesTimer;
+    QHash<QString, PostStore *> postStores; // <File path, Store>
+    QThreadPool saveThread;                 // Single thread, So saves of a store keep their order
+};
+
+/**
+Write a snapshot of a timeline to its store, On the save thread
+*/
+class SaveTimelineTask : public QRunnable
+{
+public:
+    SaveTimelineTask(PostStore *store, const PostStore::Snapshot &snapshot, PostStore *archive,
+                     SearchIndex *index, const QString &alias, const QString &timelineName)
+        : store(store), snapshot(snapshot), archive(archive), index(index), alias(alias),
+          timelineName(timelineName)
+    {}
+
+    void run() override
+    {
+        QElapsedTimer timer;
+        timer.start();
+        const QStringList removed = store->save(snapshot);
+        qCDebug(CHOQOK_PERF) << "Saved" << snapshot.count() << "posts to" << store->fileName()
+                             << "in" << timer.elapsed() << "ms";
+
+        // Posts which are in neither store can't be loaded for search results anymore
+        QStringList gone;
+        for (const QString &postId: removed) {
+            if (!archive->contains(postId)) {
+                gone.append(postId);
+            }
+        }
+        index->removePosts(alias, timelineName, gone);
+    }
+
+private:
+    PostStore *store;
+    const PostStore::Snapshot snapshot;
+    PostStore *archive;
+    SearchIndex *index;
+    QString alias;
+    QString timelineName;
+};
+
+/**
+Moves posts evicted from a timeline to its archive, After saves of the timeline queued before
+*/
+class ArchivePostsTask : public QRunnable
+{
+public:
+    ArchivePostsTask(PostStore *store, PostStore *archive, const PostStore::Snapshot &snapshot)
+        : store(store), archive(archive), snapshot(snapshot)
+    {}
+
+    void run() override
+    {
+        QStringList postIds;
+        postIds.reserve(snapshot.count());
+        for (const PostStore::SnapshotEntry &entry: snapshot) {
+            postIds.append(entry.post.postId);
+        }
+        archive->append(snapshot);
+        store->remove(postIds);
+    }
+
+private:
+    PostStore *store;
+    PostStore *archive;
+    const PostStore::Snapshot snapshot;
 };
 
 MicroBlog::MicroBlog(const QString &componentName, QObject *parent)
@@ -57,11 +139,14 @@ MicroBlog::MicroBlog(const QString &componentName, QObject *parent)
     connect(BehaviorSettings::self(), &BehaviorSettings::configChanged, this,
             &MicroBlog::slotConfigChanged);
     d->saveTimelinesTimer->start();
+    d->saveThread.setMaxThreadCount(1);
 }
 
 MicroBlog::~MicroBlog()
 {
     qCDebug(CHOQOK);
+    d->saveThread.waitForDone();
+    qDeleteAll(d->postStores);
     delete d;
 }
 
@@ -202,15 +287,181 @@ void MicroBlog::updateTimelines(Account *)
     qCWarning(CHOQOK) << "MicroBlog Plugin should implement this!";
 }
 
-QList< Post * > MicroBlog::loadTimeline(Account *, const QString &)
+/**
+Read archive of older versions, A KConfig file with a group per post
+*/
+static QList<Post *> readArchiveBackup(const QString &fileName)
+{
+    QList<Post *> list;
+    const KConfig archive(fileName, KConfig::SimpleConfig);
+    for (const QString &group: archive.groupList()) {
+        const KConfigGroup grp(&archive, group);
+        Post *post = new Post;
+        post->creationDateTime = grp.readEntry("creationDateTime", QDateTime());
+        post->postId = grp.readEntry("postId", QString());
+        post->content = grp.readEntry("text", QString());
+        post->source = grp.readEntry("source", QString());
+        post->link = grp.readEntry("link", QUrl());
+        post->replyToPostId = grp.readEntry("inReplyToPostId", QString());
+        post->replyToUser.userName = grp.readEntry("inReplyToUserName", QString());
+        post->author.userId = grp.readEntry("authorId", QString());
+        post->author.userName = grp.readEntry("authorUserName", QString());
+        post->author.realName = grp.readEntry("authorRealName", QString());
+        post->author.profileImageUrl = grp.readEntry("authorProfileImageUrl", QUrl());
+        post->repeatedFromUser.userName = grp.readEntry("repeatedFrom", QString());
+        post->repeatedPostId = grp.readEntry("repeatedPostId", QString());
+        post->conversationId = grp.readEntry("conversationId", QString());
+        post->media = grp.readEntry("mediaUrl", QUrl());
+        post->isRead = true;
+        list.append(post);
+    }
+    return list;
+}
+
+/**
+@return Archive store of @p timelineName, Archive of older versions is migrated to it on first use
+*/
+static PostStore *archiveStore(MicroBlog *microblog, Account *account, const QString &timelineName)
+{
+    const QString archiveName = timelineName + QLatin1String("_archive");
+    PostStore *archive = microblog->postStore(account, archiveName);
+    if (!archive->exists()) {
+        const QString backup = QStandardPaths::locate(QStandardPaths::DataLocation,
+                               AccountManager::generatePostBackupFileName(account->alias(), archiveName));
+        if (!backup.isEmpty()) {
+            const QList<Post *> list = readArchiveBackup(backup);
+            archive->append(list);
+            qDeleteAll(list);
+            if (archive->exists() || list.isEmpty()) {
+                QFile::remove(backup);
+            }
+        }
+    }
+    return archive;
+}
+
+QList< Post * > MicroBlog::loadTimeline(Account *account, const QString &timelineName, int count,
+                                        const Post *before)
+{
+    PostStore *store = postStore(account, timelineName);
+    if (!before && !store->exists()) {
+        const QString backup = QStandardPaths::locate(QStandardPaths::DataLocation,
+                               AccountManager::generatePostBackupFileName(account->alias(), timelineName));
+        if (!backup.isEmpty()) {
+            // Backups are not in order, Their groups are named by creation time
+            QList<Post *> list = loadTimelineBackup(account, timelineName);
+            std::stable_sort(list.begin(), list.end(), [](const Post *a, const Post *b) {
+                return a->creationDateTime < b->creationDateTime;
+            });
+            qCDebug(CHOQOK) << "Migrating" << list.count() << "posts of" << backup;
+            store->save(list);
+            if (!store->exists() && !list.isEmpty()) {
+                return list;
+            }
+            qDeleteAll(list);
+            QFile::remove(backup);
+        }
+    }
+    if (!before) {
+        // Archive of older versions is migrated on first load too, So it's there for search
+        archiveStore(this, account, timelineName);
+    }
+    QList<Post *> list = store->load(count, before);
+    if (before) {
+        // Older pages include posts evicted to archive, Which may be newer than unread posts kept on timeline
+        const QList<Post *> archived = archiveStore(this, account, timelineName)->load(count, before);
+        QList<Post *> merged;
+        merged.reserve(list.count() + archived.count());
+        std::merge(list.constBegin(), list.constEnd(), archived.constBegin(), archived.constEnd(),
+                   std::back_inserter(merged), &PostStore::isOlder);
+        list.clear();
+        for (Post *post: merged) {
+            // A post paged in from archive is saved to timeline store too, Until it's evicted again
+            if (!list.isEmpty() && list.last()->postId == post->postId) {
+                delete post;
+            } else {
+                list.append(post);
+            }
+        }
+        if (count >= 0) {
+            while (list.count() > count) {
+                delete list.takeFirst();
+            }
+        }
+    }
+    return list;
+}
+
+QList< Post * > MicroBlog::loadTimelineBackup(Account *, const QString &)
 {
-    qCWarning(CHOQOK) << "MicroBlog Plugin should implement this!";
     return QList<Post *>();
 }
 
-void MicroBlog::saveTimeline(Account *, const QString &, const QList< UI::PostWidget * > &)
+void MicroBlog::saveTimeline(Account *account, const QString &timelineName, const QList< UI::PostWidget * > &timeline)
+{
+    QElapsedTimer timer;
+    timer.start();
+    QList<Post *> posts;
+    posts.reserve(timeline.count());
+    for (UI::PostWidget *wd: timeline) {
+        posts.append(wd->currentPost());
+    }
+    PostStore *store = postStore(account, timelineName);
+    PostStore *archive = postStore(account, timelineName + QLatin1String("_archive"));
+    d->saveThread.start(new SaveTimelineTask(store, store->snapshot(posts), archive, SearchIndex::self(),
+                                             account->alias(), timelineName));
+    qCDebug(CHOQOK_PERF) << "Snapshot of" << posts.count() << "posts of" << account->alias() << timelineName
+                         << "took" << timer.elapsed() << "ms";
+    if (Application::isShuttingDown()) {
+        // Posts are on disk before microblog reports it's ready for unload
+        d->saveThread.waitForDone();
+    }
+}
+
+void MicroBlog::archivePosts(Account *account, const QString &timelineName,
+                             const QList<UI::PostWidget *> &posts)
+{
+    if (posts.isEmpty()) {
+        return;
+    }
+    QList<Post *> list;
+    list.reserve(posts.count());
+    for (UI::PostWidget *wd: posts) {
+        list.append(wd->currentPost());
+    }
+    // On save thread, So a save queued before doesn't bring them back to timeline store
+    PostStore *archive = archiveStore(this, account, timelineName);
+    runOnSaveThread(new ArchivePostsTask(postStore(account, timelineName), archive, archive->snapshot(list)));
+}
+
+PostStore *MicroBlog::postStore(Account *account, const QString &timelineName)
+{
+    const QString path = PostStore::filePath(account->alias(), timelineName);
+    PostStore *store = d->postStores.value(path);
+    if (!store) {
+        store = new PostStore(this, path);
+        d->postStores.insert(path, store);
+    }
+    return store;
+}
+
+void MicroBlog::runOnSaveThread(QRunnable *task)
+{
+    d->saveThread.start(task);
+}
+
+Post *MicroBlog::newPost() const
+{
+    return new Post;
+}
+
+QVariantMap MicroBlog::postExtras(const Post *) const
+{
+    return QVariantMap();
+}
+
+void MicroBlog::setPostExtras(Post *, const QVariantMap &) const
 {
-    qCWarning(CHOQOK) << "MicroBlog Plugin should implement this!";
 }
 
 QUrl MicroBlog::postUrl(Account *, const QString &, const QString &) const
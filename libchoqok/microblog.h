@@ -25,6 +25,7 @@
 
 #include <QMenu>
 #include <QString>
+#include <QVariant>
 
 #include "account.h"
 #include "choqok_export.h"
@@ -33,9 +34,12 @@
 #include "plugin.h"
 
 class ChoqokEditAccountWidget;
+class QRunnable;
 
 namespace Choqok
 {
+class PostStore;
+
 namespace UI
 {
 class PostWidget;
@@ -170,7 +174,8 @@ public:
 
     /**
     @brief Save a specific timeline!
-    @Note Implementation of this is optional, i.e. One microblog may don't have timeline backup
+    Default implementation copies posts of timeline, And writes their changes to its @ref postStore()
+    on a worker thread. TimelineWidget calls this only for timelines with changes, Except on shutdown.
 
     @see loadTimeline()
     */
@@ -178,11 +183,54 @@ public:
                               const QList<UI::PostWidget *> &timeline);
     /**
     @brief Load a specific timeline!
-    @Note Implementation of this is optional, i.e. One microblog may don't have timeline backup
+    Loads up to @p count posts older than @p before, Or the newest ones when it's null. All of them
+    when @p count is negative. Posts are oldest first.
+
+    Default implementation reads timeline from its @ref postStore(), Older pages merge it with archived
+    posts by creation time. A backup of older versions is migrated to it on first load. @see loadTimelineBackup()
 
     @see saveTimeline()
     */
-    virtual QList<Post *> loadTimeline(Choqok::Account *account, const QString &timelineName);
+    virtual QList<Post *> loadTimeline(Choqok::Account *account, const QString &timelineName,
+                                       int count = -1, const Post *before = nullptr);
+
+    /**
+    @brief Keep posts evicted from a timeline by its retention limits
+    Default implementation moves posts to the archive store of timeline, named timelineName_archive,
+    On the thread timelines are saved on.
+
+    @see TimelineWidget::removeOldPosts()
+    */
+    virtual void archivePosts(Choqok::Account *account, const QString &timelineName,
+                              const QList<UI::PostWidget *> &posts);
+
+    /**
+    @return Store of posts of @p timelineName of @p account, Owned by this microblog
+    */
+    PostStore *postStore(Choqok::Account *account, const QString &timelineName);
+
+    /**
+    Run @p task on the thread timelines are saved on, After pending saves. Takes ownership of @p task.
+    Post stores of this microblog stay valid while it runs.
+    */
+    void runOnSaveThread(QRunnable *task);
+
+    /**
+    @return A new empty post, Of the class this microblog uses for its posts.
+    Used by @ref PostStore to restore posts.
+    */
+    virtual Post *newPost() const;
+
+    /**
+    @return Fields of @p post specific to this microblog, To be kept in @ref PostStore
+    @see setPostExtras()
+    */
+    virtual QVariantMap postExtras(const Post *post) const;
+
+    /**
+    Restore fields returned by @ref postExtras() to @p post
+    */
+    virtual void setPostExtras(Post *post, const QVariantMap &extras) const;
 
     /**
     \brief Create a new post
@@ -313,6 +361,13 @@ protected:
 
     virtual void setTimelineNames(const QStringList &);
     void addTimelineName(const QString &);
+
+    /**
+    @brief Read a timeline from KConfig backup of older versions
+    Used once to migrate the backup to @ref postStore(), Default implementation returns nothing.
+    */
+    virtual QList<Post *> loadTimelineBackup(Choqok::Account *account, const QString &timelineName);
+
     void setServiceName(const QString &);
     void setServiceHomepageUrl(const QString &);
 
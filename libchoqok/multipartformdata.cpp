@@ -0,0 +1,234 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+
+#include "multipartformdata.h"
+
+#include <QFile>
+#include <QUuid>
+#include <QVector>
+
+#include <KIO/StoredTransferJob>
+
+#include "libchoqokdebug.h"
+
+namespace Choqok
+{
+
+struct FormPart {
+    QByteArray data;
+    QFile *file = nullptr;  // Data is read from file, when set
+    qint64 size = 0;
+};
+
+class MultipartFormData::Private
+{
+public:
+    void append(const QByteArray &data)
+    {
+        FormPart part;
+        part.data = data;
+        part.size = data.size();
+        parts.append(part);
+        size += part.size;
+    }
+
+    /** Part header, starting with the delimiter of previous part */
+    QByteArray partHeader(const QString &name, const QString &fileName = QString(),
+                          const QByteArray &mimeType = QByteArray()) const;
+
+    QByteArray boundary;
+    QByteArray closing;
+    QVector<FormPart> parts;
+    qint64 size = 0;
+};
+
+/**
+Quotes and line breaks would end the header value, So they are escaped as browsers do.
+*/
+static QByteArray quotedHeaderValue(const QString &value)
+{
+    QByteArray result = value.toUtf8();
+    result.replace('"', "%22");
+    result.replace('\r', "%0D");
+    result.replace('\n', "%0A");
+    return '"' + result + '"';
+}
+
+QByteArray MultipartFormData::Private::partHeader(const QString &name, const QString &fileName,
+        const QByteArray &mimeType) const
+{
+    QByteArray header;
+    header.reserve(128 + boundary.size() + name.size() + fileName.size());
+    header += parts.isEmpty() ? "--" : "\r\n--";
+    header += boundary;
+    header += "\r\nContent-Disposition: form-data; name=";
+    header += quotedHeaderValue(name);
+    if (!fileName.isNull()) {
+        header += "; filename=";
+        header += quotedHeaderValue(fileName);
+        header += "\r\nContent-Type: ";
+        header += mimeType.isEmpty() ? QByteArray("application/octet-stream") : mimeType;
+    }
+    header += "\r\n\r\n";
+    return header;
+}
+
+MultipartFormData::MultipartFormData(QObject *parent)
+    : QIODevice(parent), d(new Private)
+{
+    d->boundary = "choqok-" + QUuid::createUuid().toRfc4122().toHex();
+}
+
+MultipartFormData::~MultipartFormData()
+{
+    delete d;
+}
+
+void MultipartFormData::addField(const QString &name, const QByteArray &value)
+{
+    if (isOpen()) {
+        qCWarning(CHOQOK) << "Cannot add field" << name << "to an opened form";
+        return;
+    }
+    d->append(d->partHeader(name));
+    d->append(value);
+}
+
+void MultipartFormData::addFields(const QMap<QString, QByteArray> &fields)
+{
+    for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+        addField(it.key(), it.value());
+    }
+}
+
+bool MultipartFormData::addFile(const QString &name, const QUrl &url, const QByteArray &mimeType,
+                                const QByteArray &medium)
+{
+    if (isOpen()) {
+        qCWarning(CHOQOK) << "Cannot add file" << url << "to an opened form";
+        return false;
+    }
+    FormPart part;
+    if (url.isLocalFile()) {
+        QFile *file = new QFile(url.toLocalFile(), this);
+        if (file->open(QIODevice::ReadOnly) && file->size() > 0) {
+            part.file = file;
+            part.size = file->size();
+        } else {
+            qCWarning(CHOQOK) << "Cannot open" << file->fileName() << file->errorString();
+            delete file;
+            part.data = QByteArray(medium.constData(), medium.size());
+            part.size = part.data.size();
+        }
+    } else {
+        part.data = medium;
+        part.size = medium.size();
+    }
+    if (part.size == 0) {
+        return false;
+    }
+    d->append(d->partHeader(name, url.fileName(), mimeType));
+    d->parts.append(part);
+    d->size += part.size;
+    return true;
+}
+
+QByteArray MultipartFormData::boundary() const
+{
+    return d->boundary;
+}
+
+QByteArray MultipartFormData::contentType() const
+{
+    return "multipart/form-data; boundary=" + d->boundary;
+}
+
+KIO::StoredTransferJob *MultipartFormData::post(const QUrl &url)
+{
+    if (!isOpen()) {
+        open(QIODevice::ReadOnly);
+    }
+    KIO::StoredTransferJob *job = KIO::storedHttpPost(this, url, size(), KIO::HideProgressInfo);
+    setParent(job);
+    job->addMetaData(QStringLiteral("content-type"),
+                     QStringLiteral("Content-Type: ") + QLatin1String(contentType()));
+    return job;
+}
+
+bool MultipartFormData::open(OpenMode mode)
+{
+    if (mode & QIODevice::WriteOnly) {
+        qCWarning(CHOQOK) << "Form data is read only";
+        return false;
+    }
+    if (d->closing.isEmpty()) {
+        d->closing = (d->parts.isEmpty() ? "--" : "\r\n--") + d->boundary + "--\r\n";
+        d->append(d->closing);
+    }
+    // Unbuffered, So pos() is where readData() reads from, As with QBuffer
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+qint64 MultipartFormData::size() const
+{
+    if (d->closing.isEmpty()) {
+        return d->size + (d->parts.isEmpty() ? 2 : 4) + d->boundary.size() + 4;
+    }
+    return d->size;
+}
+
+qint64 MultipartFormData::readData(char *data, qint64 maxSize)
+{
+    qint64 offset = pos();
+    qint64 partStart = 0;
+    qint64 read = 0;
+    for (const FormPart &part : qAsConst(d->parts)) {
+        if (read == maxSize) {
+            break;
+        }
+        const qint64 partEnd = partStart + part.size;
+        if (offset < partEnd) {
+            const qint64 from = offset - partStart;
+            const qint64 length = qMin(part.size - from, maxSize - read);
+            if (part.file) {
+                if (!part.file->seek(from) || part.file->read(data + read, length) != length) {
+                    qCCritical(CHOQOK) << "Cannot read" << part.file->fileName() << part.file->errorString();
+                    setErrorString(part.file->errorString());
+                    return read > 0 ? read : -1;
+                }
+            } else {
+                memcpy(data + read, part.data.constData() + from, length);
+            }
+            read += length;
+            offset += length;
+        }
+        partStart = partEnd;
+    }
+    return read;
+}
+
+qint64 MultipartFormData::writeData(const char *, qint64)
+{
+    return -1;
+}
+
+}
@@ -0,0 +1,104 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+
+#ifndef MULTIPARTFORMDATA_H
+#define MULTIPARTFORMDATA_H
+
+#include <QIODevice>
+#include <QMap>
+#include <QUrl>
+
+#include "choqok_export.h"
+
+namespace KIO
+{
+class StoredTransferJob;
+}
+
+namespace Choqok
+{
+
+/**
+@brief A multipart/form-data body, Read part by part rather than built in memory
+
+Header lines of each part are kept in small buffers, Field values and in memory media are shared
+rather than copied, And local files are read from disk only when the body is read.
+Its size, i.e. the Content-Length, is known before sending.
+Each body uses a random boundary, So it can not collide with the content.
+
+Parts must be added before the device is opened.
+@see post()
+*/
+class CHOQOK_EXPORT MultipartFormData : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit MultipartFormData(QObject *parent = nullptr);
+    ~MultipartFormData();
+
+    /**
+    Add a "form-data" field named @p name
+    */
+    void addField(const QString &name, const QByteArray &value);
+
+    /**
+    Add each name/value pair of @p fields as a field
+    */
+    void addFields(const QMap<QString, QByteArray> &fields);
+
+    /**
+    Add a file field named @p name, with the medium at @p url
+    Local files are streamed from disk, Otherwise @p medium is sent.
+    @p medium may be memory mapped by MediumReadJob, So it is copied when used for a local file.
+    @return false if there is nothing to send
+    */
+    bool addFile(const QString &name, const QUrl &url, const QByteArray &mimeType,
+                 const QByteArray &medium = QByteArray());
+
+    QByteArray boundary() const;
+
+    /**
+    @return Value of Content-Type header for this body, including the boundary
+    */
+    QByteArray contentType() const;
+
+    /**
+    Open the body and create an HTTP POST job sending it to @p url, The job takes ownership of the body.
+    Content-Type is set on the job.
+    */
+    KIO::StoredTransferJob *post(const QUrl &url);
+
+    virtual bool open(OpenMode mode) override;
+    virtual qint64 size() const override;
+
+protected:
+    virtual qint64 readData(char *data, qint64 maxSize) override;
+    virtual qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif // MULTIPARTFORMDATA_H
@@ -0,0 +1,713 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+
+#include "poststore.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+
+#include <algorithm>
+
+#include "choqoktypes.h"
+#include "libchoqokdebug.h"
+#include "microblog.h"
+
+namespace Choqok
+{
+
+static const quint32 StoreMagic = 0x43505354; // "CPST"
+static const quint32 StoreVersion = 2;
+static const QDataStream::Version StreamVersion = QDataStream::Qt_5_6;
+
+/**
+Log is compacted when it has more than this many records, And more than twice the number of posts
+*/
+static const int MinRecordsToCompact = 256;
+
+enum RecordType {
+    PutRecord = 1,      // postId, sortKey, isRead, payload
+    ReadFlagRecord = 2, // postId, isRead
+    RemoveRecord = 3    // postId
+};
+
+struct StoredPost {
+    QByteArray digest;  // of payload, To detect changed posts
+    qint64 sortKey;
+    qint64 offset;  // of its last put record in file
+    bool isRead;
+};
+
+struct Record {
+    quint8 type;
+    QString postId;
+    qint64 sortKey;
+    bool isRead;
+    QByteArray payload;
+};
+
+/**
+@return Digest of @p payload, Equal ones are taken as same payloads
+*/
+static QByteArray digest(const QByteArray &payload)
+{
+    return QCryptographicHash::hash(payload, QCryptographicHash::Sha1);
+}
+
+/**
+Posts are ordered by creation time, Kept in records so loading needs no payload parsing
+*/
+static qint64 sortKey(const Post &post)
+{
+    return post.creationDateTime.isValid() ? post.creationDateTime.toMSecsSinceEpoch() : 0;
+}
+
+class PostStore::Private
+{
+public:
+    Private(MicroBlog *microblog, const QString &path)
+        : microblog(microblog), path(path), scanned(false), readOnly(false),
+          version(StoreVersion), records(0)
+    {}
+
+    typedef QPair<qint64, QString> SortEntry;   // sortKey, postId
+
+    void scan();
+    void ensureScanned();
+    bool readPayloads(const QVector<SortEntry> &entries, QHash<QString, QByteArray> *payloads) const;
+    static QByteArray serialize(const Post &post, const QVariantMap &extras);
+    Post *deserialize(const QByteArray &payload) const;
+    void write(const QByteArray &data, const QHash<QString, qint64> &offsets,
+               const QHash<QString, QByteArray> &payloads);
+    bool appendRecords(const QByteArray &data, const QHash<QString, qint64> &offsets);
+    bool compact(QHash<QString, QByteArray> payloads);
+    QVector<SortEntry> sortedPosts() const;
+    QVector<SortEntry> page(int count, const Post *before) const;
+
+    MicroBlog *microblog;
+    QString path;
+    QHash<QString, StoredPost> posts;
+    bool scanned;
+    bool readOnly;          // File is of an unknown format and could not be moved aside, It's left as it is
+    quint32 version;        // of file
+    int records;
+    QMutex mutex;           // Stores are saved on a worker thread
+};
+
+static void writeRecord(QDataStream &out, RecordType type, const QString &postId, bool isRead = false,
+                        const QByteArray &payload = QByteArray(), qint64 key = 0)
+{
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream.setVersion(StreamVersion);
+    stream << quint8(type) << postId;
+    if (type == PutRecord) {
+        stream << key;
+    }
+    if (type != RemoveRecord) {
+        stream << isRead;
+    }
+    if (type == PutRecord) {
+        stream << payload;
+    }
+    // Length prefixed, So a torn record at the end of file can be detected
+    out << record;
+}
+
+static bool parseRecord(const QByteArray &data, quint32 version, Record *record)
+{
+    QDataStream stream(data);
+    stream.setVersion(StreamVersion);
+    record->sortKey = 0;
+    record->isRead = false;
+    stream >> record->type >> record->postId;
+    if (record->type == PutRecord && version >= 2) {
+        stream >> record->sortKey;
+    }
+    if (record->type != RemoveRecord) {
+        stream >> record->isRead;
+    }
+    if (record->type == PutRecord) {
+        stream >> record->payload;
+        if (version < 2) {
+            // Payload starts with creation time
+            QDataStream payloadStream(record->payload);
+            payloadStream.setVersion(StreamVersion);
+            QDateTime creationDateTime;
+            payloadStream >> creationDateTime;
+            record->sortKey = creationDateTime.isValid() ? creationDateTime.toMSecsSinceEpoch() : 0;
+        }
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+static void writeUser(QDataStream &out, const User &user)
+{
+    out << user.userId << user.realName << user.userName << user.location << user.description
+        << user.profileImageUrl << user.homePageUrl << user.isProtected;
+}
+
+static void readUser(QDataStream &in, User &user)
+{
+    in >> user.userId >> user.realName >> user.userName >> user.location >> user.description
+       >> user.profileImageUrl >> user.homePageUrl >> user.isProtected;
+}
+
+QByteArray PostStore::Private::serialize(const Post &post, const QVariantMap &extras)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(StreamVersion);
+    out << post.creationDateTime << post.postId << post.link << post.content << post.source
+        << post.replyToPostId;
+    writeUser(out, post.replyToUser);
+    out << post.isFavorited;
+    writeUser(out, post.author);
+    out << post.type << post.isPrivate;
+    writeUser(out, post.repeatedFromUser);
+    out << post.repeatedPostId << post.repeatedDateTime << post.conversationId << post.media;
+    writeUser(out, post.quotedPost.user);
+    out << post.quotedPost.postId << post.quotedPost.content
+        << qint8(post.direction) << qint8(post.quotedPost.direction)
+        << extras;
+    return payload;
+}
+
+static bool readPost(const QByteArray &payload, Post *post, QVariantMap *extras)
+{
+    QDataStream in(payload);
+    in.setVersion(StreamVersion);
+    qint8 direction;
+    qint8 quotedDirection;
+    in >> post->creationDateTime >> post->postId >> post->link >> post->content >> post->source
+       >> post->replyToPostId;
+    readUser(in, post->replyToUser);
+    in >> post->isFavorited;
+    readUser(in, post->author);
+    in >> post->type >> post->isPrivate;
+    readUser(in, post->repeatedFromUser);
+    in >> post->repeatedPostId >> post->repeatedDateTime >> post->conversationId >> post->media;
+    readUser(in, post->quotedPost.user);
+    in >> post->quotedPost.postId >> post->quotedPost.content >> direction >> quotedDirection >> *extras;
+    post->direction = Qt::LayoutDirection(direction);
+    post->quotedPost.direction = Qt::LayoutDirection(quotedDirection);
+    return in.status() == QDataStream::Ok;
+}
+
+Post *PostStore::Private::deserialize(const QByteArray &payload) const
+{
+    Post *post = microblog->newPost();
+    QVariantMap extras;
+    if (!readPost(payload, post, &extras)) {
+        qCWarning(CHOQOK) << "Corrupted post record in" << path;
+        delete post;
+        return nullptr;
+    }
+    microblog->setPostExtras(post, extras);
+    return post;
+}
+
+void PostStore::Private::scan()
+{
+    posts.clear();
+    records = 0;
+    scanned = true;
+    readOnly = false;
+    version = StoreVersion;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return;
+    }
+    QDataStream in(&file);
+    in.setVersion(StreamVersion);
+    quint32 magic = 0;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != StoreMagic || version > StoreVersion) {
+        // e.g. of a newer version, Which must not be overwritten. A new store starts next to it.
+        file.close();
+        const QString aside = path + (magic == StoreMagic ? QStringLiteral(".v%1").arg(version)
+                                                          : QStringLiteral(".unknown"));
+        if (!QFile::exists(aside) && QFile::rename(path, aside)) {
+            qCWarning(CHOQOK_PERF) << "Unknown post store format in" << path << "Moved it to" << aside;
+        } else {
+            qCWarning(CHOQOK_PERF) << "Unknown post store format in" << path << "Leaving it untouched";
+            readOnly = true;
+        }
+        version = StoreVersion;
+        return;
+    }
+    qint64 validSize = file.pos();
+    while (!in.atEnd()) {
+        QByteArray data;
+        in >> data;
+        if (in.status() != QDataStream::Ok) {
+            // Torn write, Drop it so new records are appended to a valid log
+            qCWarning(CHOQOK) << "Truncated post store" << path;
+            file.close();
+            QFile::resize(path, validSize);
+            break;
+        }
+        const qint64 offset = validSize;
+        validSize = file.pos();
+        ++records;
+        Record record;
+        if (!parseRecord(data, version, &record)) {
+            qCWarning(CHOQOK) << "Corrupted record in" << path;
+            continue;
+        }
+        switch (record.type) {
+        case PutRecord:
+            posts.insert(record.postId, StoredPost{digest(record.payload), record.sortKey, offset, record.isRead});
+            break;
+        case ReadFlagRecord: {
+            auto it = posts.find(record.postId);
+            if (it != posts.end()) {
+                it->isRead = record.isRead;
+            }
+            break;
+        }
+        case RemoveRecord:
+            posts.remove(record.postId);
+            break;
+        default:
+            qCWarning(CHOQOK) << "Unknown record type" << record.type << "in" << path;
+            break;
+        }
+    }
+    file.close();
+    if (version < StoreVersion) {
+        qCDebug(CHOQOK) << "Upgrading post store" << path;
+        compact(QHash<QString, QByteArray>());
+    }
+}
+
+void PostStore::Private::ensureScanned()
+{
+    if (!QFile::exists(path)) {
+        // e.g. removed with its account
+        posts.clear();
+        records = 0;
+        scanned = true;
+        readOnly = false;
+        version = StoreVersion;
+    } else if (!scanned) {
+        scan();
+    }
+}
+
+/**
+Read payloads of @p entries which are not in @p payloads yet, From their records in file
+*/
+bool PostStore::Private::readPayloads(const QVector<SortEntry> &entries, QHash<QString, QByteArray> *payloads) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(CHOQOK) << "Cannot read post store" << path << file.errorString();
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(StreamVersion);
+    for (const SortEntry &entry: entries) {
+        if (payloads->contains(entry.second) || !file.seek(posts.value(entry.second).offset)) {
+            continue;
+        }
+        QByteArray data;
+        in >> data;
+        Record record;
+        if (in.status() != QDataStream::Ok || !parseRecord(data, version, &record) ||
+                record.type != PutRecord || record.postId != entry.second) {
+            qCWarning(CHOQOK) << "Corrupted post record in" << path;
+            in.resetStatus();
+            continue;
+        }
+        payloads->insert(entry.second, record.payload);
+    }
+    return true;
+}
+
+bool PostStore::Private::appendRecords(const QByteArray &data, const QHash<QString, qint64> &offsets)
+{
+    QFile file(path);
+    const bool isNew = !file.exists() || file.size() == 0;
+    if (isNew) {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+    }
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCWarning(CHOQOK) << "Cannot write post store" << path << file.errorString();
+        return false;
+    }
+    if (isNew) {
+        QDataStream out(&file);
+        out.setVersion(StreamVersion);
+        out << StoreMagic << StoreVersion;
+        file.flush();
+    }
+    const qint64 base = file.size();
+    if (file.write(data) != data.size()) {
+        qCWarning(CHOQOK) << "Cannot write post store" << path << file.errorString();
+        return false;
+    }
+    for (auto it = offsets.constBegin(); it != offsets.constEnd(); ++it) {
+        posts[it.key()].offset = base + it.value();
+    }
+    return true;
+}
+
+/**
+Rewrite the log with a record per stored post, In creation order
+Payloads of posts which are not in @p payloads are read from current log.
+*/
+bool PostStore::Private::compact(QHash<QString, QByteArray> payloads)
+{
+    const QVector<SortEntry> order = sortedPosts();
+    if (payloads.count() < order.count()) {
+        readPayloads(order, &payloads);
+    }
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(CHOQOK) << "Cannot write post store" << path << file.errorString();
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(StreamVersion);
+    out << StoreMagic << StoreVersion;
+    for (const SortEntry &entry: order) {
+        auto it = posts.find(entry.second);
+        if (!payloads.contains(entry.second)) {
+            posts.erase(it);    // Unreadable
+            continue;
+        }
+        it->offset = file.pos();
+        writeRecord(out, PutRecord, entry.second, it->isRead, payloads.value(entry.second), entry.first);
+    }
+    if (!file.commit()) {
+        qCWarning(CHOQOK) << "Cannot write post store" << path << file.errorString();
+        return false;
+    }
+    records = posts.count();
+    version = StoreVersion;
+    return true;
+}
+
+/**
+Write @p data records to log, Or compact it when most of its records are outdated
+@p offsets are positions of new put records in @p data, @p payloads are the ones known to caller.
+*/
+void PostStore::Private::write(const QByteArray &data, const QHash<QString, qint64> &offsets,
+                               const QHash<QString, QByteArray> &payloads)
+{
+    if (readOnly) {
+        return;
+    }
+    bool ok;
+    if (records > MinRecordsToCompact && records > 2 * posts.count()) {
+        ok = compact(payloads);
+    } else {
+        ok = appendRecords(data, offsets);
+    }
+    if (!ok) {
+        // Index may not match the file anymore
+        scanned = false;
+    }
+}
+
+QVector<PostStore::Private::SortEntry> PostStore::Private::sortedPosts() const
+{
+    QVector<SortEntry> order;
+    order.reserve(posts.count());
+    for (auto it = posts.constBegin(); it != posts.constEnd(); ++it) {
+        order.append(qMakePair(it->sortKey, it.key()));
+    }
+    std::sort(order.begin(), order.end());
+    return order;
+}
+
+/**
+@return Up to @p count posts older than @p before, Or the newest ones when it's null. Oldest first.
+*/
+QVector<PostStore::Private::SortEntry> PostStore::Private::page(int count, const Post *before) const
+{
+    const QVector<SortEntry> order = sortedPosts();
+    int end = order.count();
+    if (before) {
+        end = std::lower_bound(order.constBegin(), order.constEnd(),
+                               qMakePair(sortKey(*before), before->postId)) - order.constBegin();
+    }
+    const int begin = count < 0 ? 0 : qMax(0, end - count);
+    return order.mid(begin, end - begin);
+}
+
+PostStore::PostStore(MicroBlog *microblog, const QString &filePath)
+    : d(new Private(microblog, filePath))
+{
+}
+
+PostStore::~PostStore()
+{
+    delete d;
+}
+
+QString PostStore::filePath(const QString &alias, const QString &timelineName)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::DataLocation) + QLatin1Char('/') +
+           alias + QLatin1Char('_') + timelineName + QLatin1String("_posts");
+}
+
+bool PostStore::isOlder(const Post *a, const Post *b)
+{
+    return qMakePair(sortKey(*a), a->postId) < qMakePair(sortKey(*b), b->postId);
+}
+
+QString PostStore::fileName() const
+{
+    return d->path;
+}
+
+bool PostStore::exists() const
+{
+    return QFile::exists(d->path);
+}
+
+QList<Post *> PostStore::load(int count, const Post *before)
+{
+    QMutexLocker locker(&d->mutex);
+    d->ensureScanned();
+    const QVector<Private::SortEntry> order = d->page(count, before);
+
+    QHash<QString, QByteArray> payloads;
+    d->readPayloads(order, &payloads);
+    QList<Post *> list;
+    list.reserve(order.count());
+    for (const Private::SortEntry &entry: order) {
+        if (!payloads.contains(entry.second)) {
+            continue;
+        }
+        Post *post = d->deserialize(payloads.value(entry.second));
+        if (post) {
+            post->isRead = d->posts.value(entry.second).isRead;
+            list.append(post);
+        }
+    }
+    return list;
+}
+
+QList<Post *> PostStore::loadPosts(const QStringList &postIds)
+{
+    QMutexLocker locker(&d->mutex);
+    d->ensureScanned();
+    QVector<Private::SortEntry> entries;
+    entries.reserve(postIds.count());
+    for (const QString &postId: postIds) {
+        auto it = d->posts.constFind(postId);
+        if (it != d->posts.constEnd()) {
+            entries.append(qMakePair(it->sortKey, postId));
+        }
+    }
+    QHash<QString, QByteArray> payloads;
+    d->readPayloads(entries, &payloads);
+    QList<Post *> list;
+    list.reserve(entries.count());
+    for (const Private::SortEntry &entry: entries) {
+        auto it = payloads.constFind(entry.second);
+        Post *post = it == payloads.constEnd() ? nullptr : d->deserialize(it.value());
+        if (post) {
+            post->isRead = d->posts.value(entry.second).isRead;
+            list.append(post);
+        }
+    }
+    return list;
+}
+
+PostStore::Snapshot PostStore::read(int count, const Post *before)
+{
+    QMutexLocker locker(&d->mutex);
+    d->ensureScanned();
+    const QVector<Private::SortEntry> order = d->page(count, before);
+    QHash<QString, QByteArray> payloads;
+    d->readPayloads(order, &payloads);
+    Snapshot snapshot;
+    snapshot.reserve(order.count());
+    for (const Private::SortEntry &entry: order) {
+        auto it = payloads.constFind(entry.second);
+        if (it == payloads.constEnd()) {
+            continue;
+        }
+        SnapshotEntry snapshotEntry;
+        if (readPost(it.value(), &snapshotEntry.post, &snapshotEntry.extras)) {
+            snapshotEntry.post.isRead = d->posts.value(entry.second).isRead;
+            snapshot.append(snapshotEntry);
+        }
+    }
+    return snapshot;
+}
+
+PostStore::Snapshot PostStore::snapshot(const QList<Post *> &posts) const
+{
+    Snapshot snapshot;
+    snapshot.reserve(posts.count());
+    for (const Post *post: posts) {
+        snapshot.append(SnapshotEntry{*post, d->microblog->postExtras(post)});
+    }
+    return snapshot;
+}
+
+void PostStore::save(const QList<Post *> &posts)
+{
+    save(snapshot(posts));
+}
+
+QStringList PostStore::save(const Snapshot &snapshot)
+{
+    QMutexLocker locker(&d->mutex);
+    d->ensureScanned();
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(StreamVersion);
+    int written = 0;
+    QStringList removed;
+    QHash<QString, QByteArray> payloads;
+    QHash<QString, qint64> offsets;
+    Private::SortEntry oldest;
+    for (const SnapshotEntry &snapshotEntry: snapshot) {
+        const Post &post = snapshotEntry.post;
+        if (post.postId.isEmpty() || payloads.contains(post.postId)) {
+            continue;
+        }
+        const qint64 key = sortKey(post);
+        const Private::SortEntry entry(key, post.postId);
+        if (payloads.isEmpty() || entry < oldest) {
+            oldest = entry;
+        }
+        const QByteArray payload = Private::serialize(post, snapshotEntry.extras);
+        const QByteArray payloadDigest = digest(payload);
+        auto it = d->posts.find(post.postId);
+        if (it == d->posts.end() || it->digest != payloadDigest) {
+            offsets.insert(post.postId, data.size());
+            writeRecord(out, PutRecord, post.postId, post.isRead, payload, key);
+            d->posts.insert(post.postId, StoredPost{payloadDigest, key, -1, post.isRead});
+            ++written;
+        } else if (it->isRead != post.isRead) {
+            writeRecord(out, ReadFlagRecord, post.postId, post.isRead);
+            it->isRead = post.isRead;
+            ++written;
+        }
+        payloads.insert(post.postId, payload);
+    }
+    // Posts older than given ones are not loaded yet, So they are kept
+    for (auto it = d->posts.begin(); it != d->posts.end();) {
+        if (payloads.isEmpty() || payloads.contains(it.key()) ||
+                Private::SortEntry(it->sortKey, it.key()) < oldest) {
+            ++it;
+        } else {
+            writeRecord(out, RemoveRecord, it.key());
+            removed.append(it.key());
+            it = d->posts.erase(it);
+            ++written;
+        }
+    }
+    if (written == 0) {
+        return removed;
+    }
+    d->records += written;
+    d->write(data, offsets, payloads);
+    return removed;
+}
+
+void PostStore::append(const QList<Post *> &posts)
+{
+    append(snapshot(posts));
+}
+
+void PostStore::append(const Snapshot &snapshot)
+{
+    QMutexLocker locker(&d->mutex);
+    d->ensureScanned();
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(StreamVersion);
+    QHash<QString, QByteArray> payloads;
+    QHash<QString, qint64> offsets;
+    for (const SnapshotEntry &snapshotEntry: snapshot) {
+        const Post &post = snapshotEntry.post;
+        if (post.postId.isEmpty() || d->posts.contains(post.postId)) {
+            continue;
+        }
+        const QByteArray payload = Private::serialize(post, snapshotEntry.extras);
+        const qint64 key = sortKey(post);
+        offsets.insert(post.postId, data.size());
+        writeRecord(out, PutRecord, post.postId, post.isRead, payload, key);
+        d->posts.insert(post.postId, StoredPost{digest(payload), key, -1, post.isRead});
+        payloads.insert(post.postId, payload);
+    }
+    if (payloads.isEmpty()) {
+        return;
+    }
+    d->records += payloads.count();
+    d->write(data, offsets, payloads);
+}
+
+void PostStore::remove(const QStringList &postIds)
+{
+    QMutexLocker locker(&d->mutex);
+    d->ensureScanned();
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(StreamVersion);
+    int written = 0;
+    for (const QString &postId: postIds) {
+        if (d->posts.remove(postId)) {
+            writeRecord(out, RemoveRecord, postId);
+            ++written;
+        }
+    }
+    if (written == 0) {
+        return;
+    }
+    d->records += written;
+    d->write(data, QHash<QString, qint64>(), QHash<QString, QByteArray>());
+}
+
+bool PostStore::contains(const QString &postId)
+{
+    QMutexLocker locker(&d->mutex);
+    d->ensureScanned();
+    return d->posts.contains(postId);
+}
+
+int PostStore::count()
+{
+    QMutexLocker locker(&d->mutex);
+    d->ensureScanned();
+    return d->posts.count();
+}
+
+}
@@ -0,0 +1,157 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+
+#ifndef POSTSTORE_H
+#define POSTSTORE_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+#include "choqok_export.h"
+#include "choqoktypes.h"
+
+namespace Choqok
+{
+
+class MicroBlog;
+
+/**
+@brief Persistent storage of the posts of one timeline
+
+Posts are kept in an append only log: Saving writes a record for each new or changed post,
+A smaller one for each changed read flag, And one for each post which left the timeline.
+Unchanged posts cost nothing. The log is compacted when most of its records are outdated.
+A file of an unknown format, e.g. of a newer version, is moved aside with a suffix and never overwritten.
+
+Posts are keyed by their postId, And each record keeps the creation time of its post as sort key.
+So posts are loaded in order without parsing them first, And compaction writes them in that order.
+
+Fields specific to a microblog are kept with @ref MicroBlog::postExtras(), And posts are
+restored as @ref MicroBlog::newPost() objects.
+
+A store can be saved or appended to on another thread from a @ref snapshot() of posts,
+And @ref read() or removed from there. Other methods must be called on thread of its microblog.
+
+@see MicroBlog::postStore()
+*/
+class CHOQOK_EXPORT PostStore
+{
+public:
+    /**
+    Plain copy of a post, With its fields specific to microblog
+    */
+    struct SnapshotEntry {
+        Post post;
+        QVariantMap extras;
+    };
+    typedef QVector<SnapshotEntry> Snapshot;
+
+    PostStore(MicroBlog *microblog, const QString &filePath);
+    ~PostStore();
+
+    /**
+    @return Path of store file of timeline @p timelineName of account @p alias
+    */
+    static QString filePath(const QString &alias, const QString &timelineName);
+
+    QString fileName() const;
+
+    /**
+    @return true if @p a comes before @p b in stores, By creation time and then by postId
+    */
+    static bool isOlder(const Post *a, const Post *b);
+
+    bool exists() const;
+
+    /**
+    @return Up to @p count stored posts older than @p before, Or the newest ones when it's null.
+    All of them when @p count is negative. Posts are oldest first, And caller takes their ownership.
+    So older pages are loaded by passing the oldest post of previous page as @p before.
+    */
+    QList<Post *> load(int count = -1, const Post *before = nullptr);
+
+    /**
+    @return Stored posts with @p postIds, In the same order. Caller takes their ownership.
+    */
+    QList<Post *> loadPosts(const QStringList &postIds);
+
+    /**
+    @return Copies of stored posts, Paged as @ref load() does. Thread safe.
+    Store is locked while a page is read, So large stores are better read in pages.
+    */
+    Snapshot read(int count = -1, const Post *before = nullptr);
+
+    /**
+    Make the store content @p posts, And stored posts older than all of them
+    Records are appended for new and changed posts and read flags, And for other stored posts which
+    are not older than @p posts. So posts of pages which are not loaded yet are kept.
+    */
+    void save(const QList<Post *> &posts);
+
+    /**
+    @return Copies of @p posts, Which can be passed to @ref save() on another thread
+    */
+    Snapshot snapshot(const QList<Post *> &posts) const;
+
+    /**
+    Same as save(const QList<Post *> &), For posts copied by @ref snapshot(). Thread safe.
+    @return postIds of posts removed from store
+    */
+    QStringList save(const Snapshot &snapshot);
+
+    /**
+    Add @p posts which are not stored yet, Nothing is removed
+    */
+    void append(const QList<Post *> &posts);
+
+    /**
+    Same as append(const QList<Post *> &), For posts copied by @ref snapshot(). Thread safe.
+    */
+    void append(const Snapshot &snapshot);
+
+    /**
+    Remove posts with @p postIds. Thread safe.
+    */
+    void remove(const QStringList &postIds);
+
+    /**
+    @return true if a post with @p postId is stored. Thread safe.
+    */
+    bool contains(const QString &postId);
+
+    /**
+    @return Number of stored posts
+    */
+    int count();
+
+private:
+    Q_DISABLE_COPY(PostStore)
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif // POSTSTORE_H
@@ -0,0 +1,753 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+
+#include "searchindex.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QReadLocker>
+#include <QReadWriteLock>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+#include <QWriteLocker>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include "account.h"
+#include "accountmanager.h"
+#include "choqoktypes.h"
+#include "libchoqokdebug.h"
+#include "microblog.h"
+#include "poststore.h"
+
+namespace Choqok
+{
+
+/**
+An occurrence of a term is a document number in high bits, And position of word in content in low bits
+Words after MaxPosition share the last position, So phrases are matched only in first MaxPosition words.
+*/
+static const int PositionBits = 8;
+static const quint32 MaxPosition = (1u << PositionBits) - 1;
+static const int MaxDocuments = 1 << (32 - PositionBits);
+
+/**
+Words longer than this are not indexed, They are mostly encoded data
+*/
+static const int MaxWordLength = 64;
+
+/**
+A prefix matches at most this many terms, In order of terms
+*/
+static const int MaxPrefixTerms = 128;
+
+/**
+Removed documents are dropped from index once they are this fraction of all
+*/
+static const int CompactionRatio = 4;
+
+/**
+Stored posts are read and indexed in batches, So searches and store users wait at most for one of them
+*/
+static const int IndexBatchSize = 1000;
+
+// BM25 parameters
+static const qreal K1 = 1.2;
+static const qreal B = 0.75;
+
+struct Document {
+    QString postId;
+    qint64 creationTime;        // msecs since epoch
+    quint16 alias;              // index in Private::aliases
+    QVector<quint16> timelines; // indexes in Private::timelines, Of timelines which store the post
+    quint16 length;             // words in content
+    bool removed;               // Stored on no timeline anymore, Skipped by search until compaction
+};
+
+typedef QPair<QString, quint32> Term; // term, position
+
+/**
+Terms of a post, Ready to be inserted to index
+*/
+struct IndexedPost {
+    QString postId;
+    qint64 creationTime;
+    int length;
+    QVector<Term> terms;
+};
+
+/**
+A query term, All words of a phrase must follow each other
+*/
+struct Clause {
+    QStringList words;
+    bool prefix;
+};
+
+static bool isWordChar(const QChar &c)
+{
+    return c.isLetterOrNumber() || c == QLatin1Char('_');
+}
+
+/**
+@return Case folded words of @p text
+Words after # and @ are indexed as hashtags and mentions too, When @p terms is given.
+*/
+static QStringList tokenize(const QString &text, QVector<Term> *terms = nullptr)
+{
+    QStringList words;
+    const int size = text.size();
+    int i = 0;
+    while (i < size) {
+        if (!isWordChar(text.at(i))) {
+            ++i;
+            continue;
+        }
+        const QChar marker = i > 0 ? text.at(i - 1) : QChar();
+        const int start = i;
+        while (i < size && isWordChar(text.at(i))) {
+            ++i;
+        }
+        if (i - start > MaxWordLength) {
+            continue;
+        }
+        const QString word = text.mid(start, i - start).toCaseFolded();
+        if (terms) {
+            const quint32 position = qMin(quint32(words.count()), MaxPosition);
+            terms->append(Term(word, position));
+            if (marker == QLatin1Char('#') || marker == QLatin1Char('@')) {
+                terms->append(Term(marker + word, position));
+            }
+        }
+        words.append(word);
+    }
+    return words;
+}
+
+/**
+@return Host of @p url without www, Lower case
+*/
+static QString urlHost(const QString &url)
+{
+    QString host = QUrl(url).host().toLower();
+    if (host.startsWith(QLatin1String("www."))) {
+        host.remove(0, 4);
+    }
+    return host;
+}
+
+/**
+@return Terms of content, Author and links of @p post
+*/
+static IndexedPost analyze(const Post &post)
+{
+    static const QRegularExpression tag(QLatin1String("<[^>]*>"));
+    static const QRegularExpression url(QLatin1String("https?://[^\\s\"'<>]+"),
+                                        QRegularExpression::CaseInsensitiveOption);
+    IndexedPost indexed;
+    indexed.postId = post.postId;
+    indexed.creationTime = post.creationDateTime.toMSecsSinceEpoch();
+
+    // Links are taken from markup too, Their words are not indexed
+    QString text = post.content;
+    QRegularExpressionMatchIterator it = url.globalMatch(text);
+    while (it.hasNext()) {
+        // A link matches its host and parent domains, But not top level ones
+        QStringList labels = urlHost(it.next().captured()).split(QLatin1Char('.'), QString::SkipEmptyParts);
+        while (labels.count() >= 2) {
+            const Term term(QLatin1String("url:") + labels.join(QLatin1Char('.')), 0);
+            if (!indexed.terms.contains(term)) {
+                indexed.terms.append(term);
+            }
+            labels.removeFirst();
+        }
+    }
+    text.replace(url, QLatin1String(" "));
+    if (text.contains(QLatin1Char('<')) || text.contains(QLatin1Char('&'))) {
+        text.replace(tag, QLatin1String(" "));
+        text.replace(QLatin1String("&lt;"), QLatin1String("<"));
+        text.replace(QLatin1String("&gt;"), QLatin1String(">"));
+        text.replace(QLatin1String("&quot;"), QLatin1String("\""));
+        text.replace(QLatin1String("&#39;"), QLatin1String("'"));
+        text.replace(QLatin1String("&nbsp;"), QLatin1String(" "));
+        text.replace(QLatin1String("&amp;"), QLatin1String("&"));
+    }
+    indexed.length = tokenize(text, &indexed.terms).count();
+
+    QStringList authors = tokenize(post.author.realName);
+    if (!post.author.userName.isEmpty()) {
+        authors.prepend(post.author.userName.toCaseFolded());
+    }
+    authors.removeDuplicates();
+    for (const QString &author: authors) {
+        indexed.terms.append(Term(QLatin1String("from:") + author, 0));
+    }
+    return indexed;
+}
+
+/**
+@return Clauses of @p query, Empty when it has no terms
+*/
+static QVector<Clause> parseQuery(const QString &query)
+{
+    QVector<Clause> clauses;
+    const int size = query.size();
+    int i = 0;
+    while (i < size) {
+        if (query.at(i).isSpace()) {
+            ++i;
+            continue;
+        }
+        Clause clause;
+        clause.prefix = false;
+        if (query.at(i) == QLatin1Char('"')) {
+            int end = query.indexOf(QLatin1Char('"'), i + 1);
+            if (end < 0) {
+                end = size;
+            }
+            clause.words = tokenize(query.mid(i + 1, end - i - 1));
+            i = end + 1;
+        } else {
+            const int start = i;
+            while (i < size && !query.at(i).isSpace()) {
+                ++i;
+            }
+            QString token = query.mid(start, i - start);
+            if (token.endsWith(QLatin1Char('*'))) {
+                clause.prefix = true;
+                token.chop(1);
+            }
+            if (token.startsWith(QLatin1String("url:"), Qt::CaseInsensitive)) {
+                QString host = token.mid(4);
+                if (!host.contains(QLatin1String("://"))) {
+                    host.prepend(QLatin1String("http://"));
+                }
+                host = urlHost(host);
+                if (!host.isEmpty()) {
+                    clause.words.append(QLatin1String("url:") + host);
+                }
+            } else if (token.startsWith(QLatin1String("from:"), Qt::CaseInsensitive)) {
+                const QStringList words = tokenize(token.mid(5));
+                if (!words.isEmpty()) {
+                    clause.words.append(QLatin1String("from:") + words.first());
+                }
+            } else if (token.startsWith(QLatin1Char('#')) || token.startsWith(QLatin1Char('@'))) {
+                const QStringList words = tokenize(token.mid(1));
+                if (!words.isEmpty()) {
+                    clause.words.append(token.at(0) + words.first());
+                }
+            } else {
+                // Words joined by punctuation, e.g. "don't", Are a phrase
+                clause.words = tokenize(token);
+            }
+        }
+        if (clause.words.count() > 1) {
+            clause.prefix = false;
+        }
+        if (!clause.words.isEmpty()) {
+            clauses.append(clause);
+        }
+    }
+    return clauses;
+}
+
+class SearchIndex::Private
+{
+public:
+    class IndexTask;
+
+    Private()
+        : totalLength(0), removedCount(0)
+    {}
+
+    /**
+    @return Index of @p value in @p list, It's appended when missing
+    */
+    static quint16 intern(QStringList &list, const QString &value)
+    {
+        int index = list.indexOf(value);
+        if (index < 0) {
+            index = list.count();
+            list.append(value);
+        }
+        return quint16(index);
+    }
+
+    /**
+    Add @p posts to index, Write lock must be held
+    */
+    void insert(const QString &alias, const QString &timelineName, const QVector<IndexedPost> &posts)
+    {
+        const quint16 aliasIndex = intern(aliases, alias);
+        const quint16 timelineIndex = intern(timelines, timelineName);
+        for (const IndexedPost &post: posts) {
+            const DocumentKey key(aliasIndex, post.postId);
+            const auto it = documentIds.constFind(key);
+            if (it != documentIds.constEnd()) {
+                // A post on several timelines is one document, Owned by all of them
+                QVector<quint16> &owners = documents[it.value()].timelines;
+                if (!owners.contains(timelineIndex)) {
+                    owners.append(timelineIndex);
+                }
+                continue;
+            }
+            if (documents.count() >= MaxDocuments && removedCount > 0) {
+                compact();
+            }
+            if (documents.count() >= MaxDocuments) {
+                qCWarning(CHOQOK) << "Search index is full, Posts are not indexed anymore";
+                return;
+            }
+            const quint32 doc = documents.count();
+            Document document;
+            document.postId = post.postId;
+            document.creationTime = post.creationTime;
+            document.alias = aliasIndex;
+            document.timelines.append(timelineIndex);
+            document.length = quint16(qMin(post.length, 0xffff));
+            document.removed = false;
+            documents.append(document);
+            documentIds.insert(key, doc);
+            totalLength += document.length;
+            for (const Term &term: post.terms) {
+                terms[term.first].append((doc << PositionBits) | term.second);
+            }
+        }
+    }
+
+    /**
+    Mark document @p doc removed, Write lock must be held
+    */
+    void remove(quint32 doc)
+    {
+        Document &document = documents[doc];
+        document.removed = true;
+        documentIds.remove(DocumentKey(document.alias, document.postId));
+        totalLength -= document.length;
+        ++removedCount;
+    }
+
+    /**
+    Drop removed documents and their occurrences once they are many, Write lock must be held
+    */
+    void compactIfNeeded()
+    {
+        if (removedCount > 0 && removedCount * CompactionRatio >= documents.count()) {
+            compact();
+        }
+    }
+
+    /**
+    Drop removed documents and their occurrences, Other documents are renumbered in the same order
+    */
+    void compact()
+    {
+        static const quint32 Dropped = 0xffffffff;
+        QVector<quint32> numbers(documents.count(), Dropped);
+        QVector<Document> kept;
+        kept.reserve(documents.count() - removedCount);
+        documentIds.clear();
+        for (int doc = 0; doc < documents.count(); ++doc) {
+            const Document &document = documents.at(doc);
+            if (!document.removed) {
+                numbers[doc] = kept.count();
+                documentIds.insert(DocumentKey(document.alias, document.postId), kept.count());
+                kept.append(document);
+            }
+        }
+        for (auto it = terms.begin(); it != terms.end();) {
+            QVector<quint32> occurrences;
+            for (quint32 occurrence: it.value()) {
+                const quint32 doc = numbers.at(occurrence >> PositionBits);
+                if (doc != Dropped) {
+                    occurrences.append((doc << PositionBits) | (occurrence & MaxPosition));
+                }
+            }
+            if (occurrences.isEmpty()) {
+                it = terms.erase(it);
+            } else {
+                it.value() = occurrences;
+                ++it;
+            }
+        }
+        qCDebug(CHOQOK_PERF) << "Search index dropped" << removedCount << "removed posts, Kept" << kept.count();
+        documents = kept;
+        removedCount = 0;
+    }
+
+    /**
+    Add BM25 scores of documents with a term to @p scores
+    @p occurrences are in document order, So occurrences of a document are a run.
+    */
+    void scoreTerm(const QVector<quint32> &occurrences, QHash<quint32, qreal> *scores) const
+    {
+        QVector<QPair<quint32, int>> frequencies; // document, occurrences
+        for (quint32 occurrence: occurrences) {
+            const quint32 doc = occurrence >> PositionBits;
+            if (!frequencies.isEmpty() && frequencies.last().first == doc) {
+                ++frequencies.last().second;
+            } else {
+                frequencies.append(qMakePair(doc, 1));
+            }
+        }
+        score(frequencies, scores);
+    }
+
+    /**
+    Add BM25 scores of documents with @p frequencies of a term to @p scores
+    */
+    void score(const QVector<QPair<quint32, int>> &frequencies, QHash<quint32, qreal> *scores) const
+    {
+        const qreal count = qMax(1, documents.count() - removedCount);
+        const qreal df = frequencies.count();
+        const qreal idf = std::log(1 + (count - df + 0.5) / (df + 0.5));
+        const qreal averageLength = qMax(qreal(1), totalLength / count);
+        for (const auto &frequency: frequencies) {
+            const qreal tf = frequency.second;
+            const qreal length = documents.at(frequency.first).length;
+            (*scores)[frequency.first] += idf * tf * (K1 + 1) / (tf + K1 * (1 - B + B * length / averageLength));
+        }
+    }
+
+    /**
+    @return Scores of documents matching @p clause
+    */
+    QHash<quint32, qreal> scoreClause(const Clause &clause) const
+    {
+        QHash<quint32, qreal> scores;
+        if (clause.prefix) {
+            // Plain words have no field, So a prefix of them doesn't match fields like from:
+            const QString &prefix = clause.words.first();
+            const bool isField = prefix.contains(QLatin1Char(':'));
+            int matched = 0;
+            for (auto it = terms.lowerBound(prefix); it != terms.constEnd() && matched < MaxPrefixTerms
+                    && it.key().startsWith(prefix); ++it) {
+                if (isField || !it.key().contains(QLatin1Char(':'))) {
+                    scoreTerm(it.value(), &scores);
+                    ++matched;
+                }
+            }
+        } else if (clause.words.count() == 1) {
+            const auto it = terms.constFind(clause.words.first());
+            if (it != terms.constEnd()) {
+                scoreTerm(it.value(), &scores);
+            }
+        } else {
+            scorePhrase(clause.words, &scores);
+        }
+        return scores;
+    }
+
+    /**
+    Add scores of documents with consecutive @p words to @p scores, A phrase is scored as one term
+    */
+    void scorePhrase(const QStringList &words, QHash<quint32, qreal> *scores) const
+    {
+        QVector<const QVector<quint32> *> lists;
+        for (const QString &word: words) {
+            const auto it = terms.constFind(word);
+            if (it == terms.constEnd()) {
+                return;
+            }
+            lists.append(&it.value());
+        }
+        // Occurrences of first word, Which are followed by the other ones
+        QVector<quint32> starts = *lists.first();
+        for (int i = 1; i < lists.count() && !starts.isEmpty(); ++i) {
+            QVector<quint32> shifted;
+            for (quint32 occurrence: *lists.at(i)) {
+                // Positions of words after MaxPosition are not known
+                const quint32 position = occurrence & MaxPosition;
+                if (position >= quint32(i) && position < MaxPosition) {
+                    shifted.append(occurrence - i);
+                }
+            }
+            QVector<quint32> matched;
+            std::set_intersection(starts.constBegin(), starts.constEnd(), shifted.constBegin(), shifted.constEnd(),
+                                  std::back_inserter(matched));
+            starts = matched;
+        }
+        scoreTerm(starts, scores);
+    }
+
+    typedef QPair<quint16, QString> DocumentKey; // alias, postId
+
+    mutable QReadWriteLock lock;
+    QStringList aliases;
+    QStringList timelines;
+    QVector<Document> documents;
+    QHash<DocumentKey, quint32> documentIds;
+    QMap<QString, QVector<quint32>> terms; // term, occurrences
+    qint64 totalLength;   // of documents which are not removed
+    int removedCount;
+};
+
+/**
+Indexes stored posts of a timeline on save thread of its microblog, So stores live while it runs
+*/
+class SearchIndex::Private::IndexTask : public QRunnable
+{
+public:
+    IndexTask(SearchIndex *index, const QString &alias, const QString &timelineName,
+              const QList<PostStore *> &stores)
+        : index(index), alias(alias), timelineName(timelineName), stores(stores)
+    {}
+
+    void run() override
+    {
+        QElapsedTimer timer;
+        timer.start();
+        int count = 0;
+        for (PostStore *store: stores) {
+            // Newest first, A page at a time, So the store isn't locked for timelines loading meanwhile
+            PostStore::Snapshot posts = store->read(IndexBatchSize);
+            while (!posts.isEmpty()) {
+                QVector<IndexedPost> batch;
+                batch.reserve(posts.count());
+                for (const PostStore::SnapshotEntry &entry: posts) {
+                    batch.append(analyze(entry.post));
+                }
+                {
+                    QWriteLocker locker(&index->d->lock);
+                    index->d->insert(alias, timelineName, batch);
+                }
+                count += posts.count();
+                const Post cursor = posts.first().post;
+                posts = store->read(IndexBatchSize, &cursor);
+            }
+        }
+        qCDebug(CHOQOK_PERF) << "Indexed" << count << "posts of" << alias << timelineName
+                             << "in" << timer.elapsed() << "ms";
+        Q_EMIT index->timelineIndexed(alias, timelineName);
+    }
+
+private:
+    SearchIndex *index;
+    QString alias;
+    QString timelineName;
+    QList<PostStore *> stores;
+};
+
+SearchIndex *SearchIndex::mSelf = nullptr;
+
+SearchIndex::SearchIndex()
+    : QObject(), d(new Private)
+{
+}
+
+SearchIndex::~SearchIndex()
+{
+    delete d;
+    mSelf = nullptr;
+}
+
+SearchIndex *SearchIndex::self()
+{
+    if (!mSelf) {
+        mSelf = new SearchIndex;
+    }
+    return mSelf;
+}
+
+void SearchIndex::addPosts(Account *account, const QString &timelineName, const QList<Post *> &posts)
+{
+    if (posts.isEmpty()) {
+        return;
+    }
+    QVector<IndexedPost> indexed;
+    indexed.reserve(posts.count());
+    for (const Post *post: posts) {
+        indexed.append(analyze(*post));
+    }
+    QWriteLocker locker(&d->lock);
+    d->insert(account->alias(), timelineName, indexed);
+}
+
+void SearchIndex::indexTimeline(Account *account, const QString &timelineName)
+{
+    MicroBlog *microblog = account->microblog();
+    const QList<PostStore *> stores {microblog->postStore(account, timelineName),
+                                     microblog->postStore(account, timelineName + QLatin1String("_archive"))};
+    microblog->runOnSaveThread(new Private::IndexTask(this, account->alias(), timelineName, stores));
+}
+
+void SearchIndex::removeAccount(const QString &alias)
+{
+    QWriteLocker locker(&d->lock);
+    const int aliasIndex = d->aliases.indexOf(alias);
+    if (aliasIndex < 0) {
+        return;
+    }
+    for (int doc = 0; doc < d->documents.count(); ++doc) {
+        const Document &document = d->documents.at(doc);
+        if (document.alias == aliasIndex && !document.removed) {
+            d->remove(doc);
+        }
+    }
+    d->compactIfNeeded();
+}
+
+void SearchIndex::removePosts(const QString &alias, const QString &timelineName, const QStringList &postIds)
+{
+    if (postIds.isEmpty()) {
+        return;
+    }
+    QWriteLocker locker(&d->lock);
+    const int aliasIndex = d->aliases.indexOf(alias);
+    const int timelineIndex = d->timelines.indexOf(timelineName);
+    if (aliasIndex < 0 || timelineIndex < 0) {
+        return;
+    }
+    for (const QString &postId: postIds) {
+        const auto it = d->documentIds.constFind(Private::DocumentKey(aliasIndex, postId));
+        if (it == d->documentIds.constEnd()) {
+            continue;
+        }
+        // Other timelines may still store the post
+        const quint32 doc = it.value();
+        QVector<quint16> &owners = d->documents[doc].timelines;
+        owners.removeOne(timelineIndex);
+        if (owners.isEmpty()) {
+            d->remove(doc);
+        }
+    }
+    d->compactIfNeeded();
+}
+
+QList<SearchResult> SearchIndex::search(const QString &query, int maxResults, const QString &alias) const
+{
+    QElapsedTimer timer;
+    timer.start();
+    QList<SearchResult> results;
+    const QVector<Clause> clauses = parseQuery(query);
+    if (clauses.isEmpty() || maxResults <= 0) {
+        return results;
+    }
+    QReadLocker locker(&d->lock);
+    const int aliasIndex = alias.isEmpty() ? -1 : d->aliases.indexOf(alias);
+    if (!alias.isEmpty() && aliasIndex < 0) {
+        return results;
+    }
+    QVector<QHash<quint32, qreal>> scores;
+    for (const Clause &clause: clauses) {
+        scores.append(d->scoreClause(clause));
+        if (scores.last().isEmpty()) {
+            return results;
+        }
+    }
+    // All clauses must match, So documents of the smallest one are checked against the others
+    std::sort(scores.begin(), scores.end(), [](const QHash<quint32, qreal> &a, const QHash<quint32, qreal> &b) {
+        return a.count() < b.count();
+    });
+    QVector<QPair<qreal, quint32>> hits; // score, document
+    for (auto it = scores.first().constBegin(); it != scores.first().constEnd(); ++it) {
+        const Document &document = d->documents.at(it.key());
+        if (document.removed || (aliasIndex >= 0 && document.alias != aliasIndex)) {
+            continue;
+        }
+        qreal score = it.value();
+        bool matches = true;
+        for (int i = 1; i < scores.count() && matches; ++i) {
+            const auto other = scores.at(i).constFind(it.key());
+            matches = other != scores.at(i).constEnd();
+            if (matches) {
+                score += other.value();
+            }
+        }
+        if (matches) {
+            hits.append(qMakePair(score, it.key()));
+        }
+    }
+    const int count = qMin(maxResults, hits.count());
+    std::partial_sort(hits.begin(), hits.begin() + count, hits.end(),
+                      [this](const QPair<qreal, quint32> &a, const QPair<qreal, quint32> &b) {
+        if (a.first != b.first) {
+            return a.first > b.first;
+        }
+        return d->documents.at(a.second).creationTime > d->documents.at(b.second).creationTime;
+    });
+    results.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const Document &document = d->documents.at(hits.at(i).second);
+        SearchResult result;
+        result.alias = d->aliases.at(document.alias);
+        result.timelineName = d->timelines.at(document.timelines.first());
+        result.postId = document.postId;
+        result.creationDateTime = QDateTime::fromMSecsSinceEpoch(document.creationTime);
+        result.score = hits.at(i).first;
+        results.append(result);
+    }
+    qCDebug(CHOQOK_PERF) << "Searched" << d->documents.count() << "posts for" << query << "found" << hits.count()
+                         << "in" << timer.elapsed() << "ms";
+    return results;
+}
+
+QList<Post *> SearchIndex::loadPosts(const QList<SearchResult> &results) const
+{
+    // Posts are read once per timeline, Then put in order of results
+    QMap<QPair<QString, QString>, QStringList> postIds; // <alias, timeline>, postIds
+    for (const SearchResult &result: results) {
+        postIds[qMakePair(result.alias, result.timelineName)].append(result.postId);
+    }
+    QHash<QPair<QString, QString>, Post *> loaded; // <alias, postId>, post
+    for (auto it = postIds.constBegin(); it != postIds.constEnd(); ++it) {
+        Account *account = AccountManager::self()->findAccount(it.key().first);
+        if (!account || !account->microblog()) {
+            continue;
+        }
+        QStringList remaining = it.value();
+        const QStringList names {it.key().second, it.key().second + QLatin1String("_archive")};
+        for (const QString &name: names) {
+            if (remaining.isEmpty()) {
+                break;
+            }
+            for (Post *post: account->microblog()->postStore(account, name)->loadPosts(remaining)) {
+                remaining.removeOne(post->postId);
+                loaded.insert(qMakePair(account->alias(), post->postId), post);
+            }
+        }
+    }
+    QList<Post *> posts;
+    for (const SearchResult &result: results) {
+        Post *post = loaded.take(qMakePair(result.alias, result.postId));
+        if (post) {
+            posts.append(post);
+        }
+    }
+    qDeleteAll(loaded);
+    return posts;
+}
+
+int SearchIndex::count() const
+{
+    QReadLocker locker(&d->lock);
+    return d->documents.count() - d->removedCount;
+}
+
+}
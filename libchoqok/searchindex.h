@@ -0,0 +1,133 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QDateTime>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include "choqok_export.h"
+
+namespace Choqok
+{
+
+class Account;
+class Post;
+
+/**
+@brief A post found by @ref SearchIndex
+*/
+class CHOQOK_EXPORT SearchResult
+{
+public:
+    QString alias;          // of account
+    QString timelineName;   // One of timelines which store the post
+    QString postId;
+    QDateTime creationDateTime;
+    qreal score;
+};
+
+/**
+@brief Local full text index of posts of all accounts and timelines
+
+Posts are indexed as they arrive on timelines, And stored posts of a timeline and its archive are
+indexed in background once it's loaded. Index is kept in memory.
+
+A query is a list of terms, Posts matching all of them are ranked by BM25 and then by creation time:
+- word: A word of content, word* for words starting with it
+- "some words": A phrase of content, Matched in the first 255 words of it
+- \#tag: A hashtag, \@name: A mention
+- from:name: Author, By user name or a word of real name
+- url:host: A link to host or its subdomains, e.g. url:kde.org
+
+@see search(), loadPosts()
+*/
+class CHOQOK_EXPORT SearchIndex : public QObject
+{
+    Q_OBJECT
+public:
+    ~SearchIndex();
+
+    static SearchIndex *self();
+
+    /**
+    Index @p posts which arrived on @p timelineName of @p account
+    Posts which are indexed already are skipped.
+    */
+    void addPosts(Account *account, const QString &timelineName, const QList<Post *> &posts);
+
+    /**
+    Index stored posts of @p timelineName of @p account and its archive, In background
+    @see MicroBlog::postStore()
+    */
+    void indexTimeline(Account *account, const QString &timelineName);
+
+    /**
+    Drop posts with @p postIds of @p timelineName of account @p alias, Which are not stored anymore. Thread safe.
+    Posts which other timelines of account store are kept.
+    */
+    void removePosts(const QString &alias, const QString &timelineName, const QStringList &postIds);
+
+    /**
+    Drop posts of account @p alias
+    */
+    void removeAccount(const QString &alias);
+
+    /**
+    @return Up to @p maxResults posts matching @p query, Best first.
+    Only posts of account @p alias are returned, Unless it's empty.
+    */
+    QList<SearchResult> search(const QString &query, int maxResults = 100,
+                               const QString &alias = QString()) const;
+
+    /**
+    @return Posts of @p results in the same order, Read from post stores without network access.
+    Caller takes their ownership, A search timeline can show them with TimelineWidget::addNewPosts().
+    Posts which are not saved yet are skipped.
+    */
+    QList<Post *> loadPosts(const QList<SearchResult> &results) const;
+
+    /**
+    @return Number of indexed posts
+    */
+    int count() const;
+
+Q_SIGNALS:
+    /**
+    Emitted when stored posts of a timeline are indexed. @see indexTimeline()
+    */
+    void timelineIndexed(const QString &alias, const QString &timelineName);
+
+private:
+    SearchIndex();
+    static SearchIndex *mSelf;
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif // SEARCHINDEX_H
@@ -0,0 +1,218 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+#include "contentpreparer.h"
+
+#include <QApplication>
+#include <QCache>
+#include <QHash>
+#include <QPointer>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include "choqokappearancesettings.h"
+#include "urlutils.h"
+
+namespace Choqok
+{
+namespace UI
+{
+
+static const QString hrefTemplate(QLatin1String("<a href='%1' title='%1' target='_blank'>%2</a>"));
+
+/**
+Count of cached linkified texts and final contents
+*/
+static const int LinkifiedCacheSize = 500;
+static const int ContentCacheSize = 2000;
+
+PreparedContent::PreparedContent()
+    : mIsNull(true)
+{
+}
+
+PreparedContent::PreparedContent(const QString &html, const QStringList &urls)
+    : mHtml(html), mUrls(urls), mIsNull(false)
+{
+}
+
+bool PreparedContent::isNull() const
+{
+    return mIsNull;
+}
+
+QString PreparedContent::html() const
+{
+    return mHtml;
+}
+
+QStringList PreparedContent::urls() const
+{
+    return mUrls;
+}
+
+class LinkifyTask : public QRunnable
+{
+public:
+    LinkifyTask(const QString &text, ContentPreparer *preparer)
+        : text(text), preparer(preparer)
+    {}
+
+    void run() override
+    {
+        const PreparedContent content = ContentPreparer::linkify(text);
+        QMetaObject::invokeMethod(preparer, "slotLinkified", Qt::QueuedConnection,
+                                  Q_ARG(QString, text), Q_ARG(Choqok::UI::PreparedContent, content));
+    }
+
+private:
+    QString text;
+    ContentPreparer *preparer;
+};
+
+struct Waiter {
+    QPointer<QObject> receiver;
+    QByteArray member;
+};
+
+class ContentPreparer::Private
+{
+public:
+    Private()
+        : linkified(LinkifiedCacheSize), contents(ContentCacheSize)
+    {}
+    ~Private()
+    {
+        // Tasks call back the preparer, So none of them may outlive it
+        linkifiers.clear();
+        linkifiers.waitForDone();
+    }
+    QThreadPool linkifiers;
+    QCache<QString, PreparedContent> linkified; // <Text, Linkified text>
+    QCache<QString, PreparedContent> contents;  // <Content key, Final content>
+    QHash<QString, QList<Waiter> > waiters;     // <Text on worker thread, Receivers>
+};
+
+ContentPreparer *ContentPreparer::mSelf = nullptr;
+
+ContentPreparer::ContentPreparer()
+    : QObject(qApp), d(new Private)
+{
+    qRegisterMetaType<Choqok::UI::PreparedContent>();
+}
+
+ContentPreparer::~ContentPreparer()
+{
+    delete d;
+    mSelf = nullptr;
+}
+
+ContentPreparer *ContentPreparer::self()
+{
+    if (!mSelf) {
+        mSelf = new ContentPreparer;
+    }
+    return mSelf;
+}
+
+PreparedContent ContentPreparer::linkify(const QString &txt)
+{
+    QString text(txt);
+    text.replace(QLatin1Char('<'), QLatin1String("&lt;"));
+    text.replace(QLatin1Char('>'), QLatin1String("&gt;"));
+
+    const QStringList urls = UrlUtils::detectUrls(text);
+    for (const QString &url: urls) {
+        QString httpUrl(url);
+        if (!httpUrl.startsWith(QLatin1String("http"), Qt::CaseInsensitive) &&
+                !httpUrl.startsWith(QLatin1String("ftp"), Qt::CaseInsensitive)) {
+            httpUrl.prepend(QLatin1String("http://"));
+            text.replace(url, httpUrl);
+        }
+
+        text.replace(url, hrefTemplate.arg(httpUrl, url));
+    }
+
+    return PreparedContent(UrlUtils::detectEmails(text), urls);
+}
+
+PreparedContent ContentPreparer::linkified(const QString &text)
+{
+    PreparedContent *cached = d->linkified.object(text);
+    if (cached) {
+        return *cached;
+    }
+    const PreparedContent content = linkify(text);
+    d->linkified.insert(text, new PreparedContent(content));
+    return content;
+}
+
+bool ContentPreparer::prepare(const QString &text, QObject *receiver, const char *member)
+{
+    if (d->linkified.contains(text)) {
+        return true;
+    }
+    Waiter waiter;
+    waiter.receiver = receiver;
+    waiter.member = member;
+    auto it = d->waiters.find(text);
+    if (it != d->waiters.end()) {
+        ///The text is on the way
+        it.value().append(waiter);
+        return false;
+    }
+    d->waiters.insert(text, QList<Waiter>() << waiter);
+    d->linkifiers.start(new LinkifyTask(text, this));
+    return false;
+}
+
+void ContentPreparer::slotLinkified(const QString &text, const PreparedContent &content)
+{
+    d->linkified.insert(text, new PreparedContent(content));
+    const QList<Waiter> waiters = d->waiters.take(text);
+    for (const Waiter &waiter: waiters) {
+        if (waiter.receiver) {
+            QMetaObject::invokeMethod(waiter.receiver, waiter.member.constData());
+        }
+    }
+}
+
+PreparedContent ContentPreparer::content(const QString &key) const
+{
+    PreparedContent *cached = d->contents.object(key);
+    return cached ? *cached : PreparedContent();
+}
+
+void ContentPreparer::insertContent(const QString &key, const PreparedContent &content)
+{
+    d->contents.insert(key, new PreparedContent(content));
+}
+
+QString ContentPreparer::contentKey(const QString &alias, const QString &postId, const QString &text,
+                                    const QObject *preparer)
+{
+    const int settingsHash = AppearanceSettings::isEmoticonsEnabled() ? 1 : 0;
+    return QStringLiteral("%1/%2/%3/%4/%5").arg(QLatin1String(preparer->metaObject()->className()))
+           .arg(settingsHash).arg(alias, postId).arg(qHash(text));
+}
+
+}
+}
@@ -0,0 +1,130 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+#ifndef CONTENTPREPARER_H
+#define CONTENTPREPARER_H
+
+#include <QObject>
+#include <QStringList>
+
+#include "choqok_export.h"
+
+namespace Choqok
+{
+namespace UI
+{
+
+/**
+@brief Immutable result of preparing the text of a post for display
+*/
+class CHOQOK_EXPORT PreparedContent
+{
+public:
+    PreparedContent();
+    PreparedContent(const QString &html, const QStringList &urls);
+
+    bool isNull() const;
+
+    /**
+    @return Prepared HTML of text
+    */
+    QString html() const;
+
+    /**
+    @return URLs detected on text
+    */
+    QStringList urls() const;
+
+private:
+    QString mHtml;
+    QStringList mUrls;
+    bool mIsNull;
+};
+
+/**
+@brief Prepares the text of posts on a worker thread, and caches the results
+
+Preparation has two stages:
+@li Linkify: Escaping tags, and linking URLs and emails of the text. This is the expensive and
+thread safe part, and runs on a worker thread by @ref prepare(). Results are cached by text.
+@li The rest of @ref PostWidget::prepareStatus() chain (e.g. mentions, hashtags and emoticons) which
+runs on the GUI thread, on top of linkified text. Final results are cached by @ref contentKey()
+So the same post shown on several timelines, conversations or notifications is prepared once.
+
+@see PostWidget::prepareStatus()
+*/
+class CHOQOK_EXPORT ContentPreparer : public QObject
+{
+    Q_OBJECT
+public:
+    ~ContentPreparer();
+
+    static ContentPreparer *self();
+
+    /**
+    Escape tags, and link URLs and emails of @p text
+    @Note This is thread safe
+    */
+    static PreparedContent linkify(const QString &text);
+
+    /**
+    @return Linkified @p text from cache, or linkify it now on the calling thread.
+    */
+    PreparedContent linkified(const QString &text);
+
+    /**
+    Linkify @p text on a worker thread, and invoke @p member of @p receiver on GUI thread when it's done.
+
+    @return true if @p text is linkified already, in this case nothing will be invoked.
+    */
+    bool prepare(const QString &text, QObject *receiver, const char *member);
+
+    /**
+    @return Final content cached with @p key or a null one
+    */
+    PreparedContent content(const QString &key) const;
+
+    void insertContent(const QString &key, const PreparedContent &content);
+
+    /**
+    @return Key of final content of @p text of post @p postId of account @p alias, prepared by @p preparer
+    Includes a hash of settings which affect the preparation. Links of mentions point to server of account,
+    So accounts don't share contents.
+    */
+    static QString contentKey(const QString &alias, const QString &postId, const QString &text,
+                              const QObject *preparer);
+
+protected Q_SLOTS:
+    void slotLinkified(const QString &text, const Choqok::UI::PreparedContent &content);
+
+private:
+    ContentPreparer();
+    class Private;
+    Private *const d;
+    static ContentPreparer *mSelf;
+};
+
+}
+}
+
+Q_DECLARE_METATYPE(Choqok::UI::PreparedContent)
+
+#endif // CONTENTPREPARER_H
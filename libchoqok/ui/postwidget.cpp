@@ -22,9 +22,15 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include "postwidget.h"
 
 #include <QCloseEvent>
+#include <QElapsedTimer>
 #include <QGridLayout>
-#include <QTimer>
+#include <QGuiApplication>
 #include <QPushButton>
+#include <QScreen>
+#include <QStyle>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextTable>
 
 #include <KLocalizedString>
 #include <KMessageBox>
@@ -32,17 +38,14 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include "choqokappearancesettings.h"
 #include "choqokbehaviorsettings.h"
 #include "choqoktools.h"
+#include "contentpreparer.h"
 #include "choqokuiglobal.h"
 #include "libchoqokdebug.h"
 #include "mediamanager.h"
 #include "quickpost.h"
+#include "relativetimescheduler.h"
 #include "timelinewidget.h"
 #include "textbrowser.h"
-#include "urlutils.h"
-
-static const int _15SECS = 15000;
-static const int _MINUTE = 60000;
-static const int _HOUR = 60 * _MINUTE;
 
 using namespace Choqok;
 using namespace Choqok::UI;
@@ -51,7 +54,9 @@ class PostWidget::Private
 {
 public:
     Private(Account *account, Choqok::Post *post)
-        : mCurrentPost(post), mCurrentAccount(account), dir(QLatin1String("ltr")), timeline(nullptr)
+        : mCurrentPost(post), mCurrentAccount(account), dir(QLatin1String("ltr")), timeline(nullptr),
+          realized(true), renderPending(false), rendering(false), timestampStale(false), hasRendered(false),
+          heightsKey(0), laidOutWidth(-1), appliedStyleSheet(-1)
     {
         mCurrentPost->owners++;
 
@@ -64,7 +69,6 @@ public:
     Post *mCurrentPost;
     Account *mCurrentAccount;
 //         bool mRead;
-    QTimer mTimer;
 
     //BEGIN UI contents:
     QString mSign;
@@ -80,14 +84,257 @@ public:
     QStringList detectedUrls;
 
     TimelineWidget *timeline;
-    
+
+    /**
+    Posts near the viewport first, then others of the current timeline, then background timelines
+    */
+    MediaManager::FetchPriority fetchPriority() const
+    {
+        if (timeline && !timeline->isVisible()) {
+            return MediaManager::LowPriority;
+        }
+        return realized ? MediaManager::HighPriority : MediaManager::NormalPriority;
+    }
+
+    bool realized;
+    bool renderPending;
+    bool rendering;     // Document is being updated, Height is measured once it's done
+
+    QString timeText; // Relative time text currently on document
+    QTextCursor timeCursor; // Selects timeText on document, Edits before it move it along
+    bool timestampStale;
+
+    // UI contents of the last full render, used to patch the document in place
+    bool hasRendered;
+    QString renderedProfileImage;
+    QString renderedContent;
+    QString renderedSign;
+    QString renderedDir;
+    QString renderedImage;
+    QString renderedExtraContents;
+    QSize imageSize;
+
+    QHash<int, QPixmap> scaledImages;   // <Width bucket, Scaled originalImage>
+    QList<int> scaledImagesOrder;       // Width buckets of scaledImages, Least recently used first
+    QHash<int, int> heights;            // <Text width, Document height>
+    uint heightsKey;                    // layoutKey() of heights
+    int laidOutWidth;
+
+    int appliedStyleSheet; // Style generation of own style sheet, when not on a timeline
+
+    QString pendingContent; // Plain content shown until worker thread prepares it
+
+    static QString decorateContent(const QString &content);
+
+    uint layoutKey() const;
+
+    bool patchImage(QTextDocument *doc);
+    bool patchContent(QTextDocument *doc);
+    bool patchTimestamp(QTextDocument *doc, const QString &newTimeText);
+    bool markTimestamp(QTextDocument *doc, const QString &newTimeText);
+
     static const QLatin1String resourceImageUrl;
+    static const QChar timePlaceholder;
 };
 
+static int lastMinuteFullRenders = 0;
+
+/**
+Incremented on each style change, height of documents depends on it.
+*/
+static int styleGeneration = 0;
+
+/**
+Generated by PostWidget::setStyle(), Colors are kept for PostWidget::backgroundColor()
+*/
+static QString postsStyle;
+static QColor unreadBackColor;
+static QColor readBackColor;
+static QColor ownBackColor;
+
+static const QLatin1String stateProperty("postState");
+static const QLatin1String highlightedProperty("highlighted");
+
+/**
+Apply changed dynamic properties of a post to its style sheet rules
+*/
+static void repolish(QWidget *widget)
+{
+    widget->style()->unpolish(widget);
+    widget->style()->polish(widget);
+    widget->update();
+}
+
+/**
+Post images are scaled to a multiple of this, to reuse scaled images on resize.
+*/
+static const int ImageWidthBucket = 32;
+static const int MaxScaledImages = 4;
+static const int AvatarSize = 48;
+
+/**
+Width around post image in baseTextTemplate, i.e. avatar column, paddings of cells and frame of text browser
+*/
+static const int ImageMargin = 76;
+
+/**
+Rough size of a laid out post document, Used by PostWidget::memoryUsage()
+*/
+static const qint64 RenderedDocumentBytes = 16 * 1024;
+
+static qint64 pixmapBytes(const QPixmap &pixmap)
+{
+    return qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
+
+static void countFullRender()
+{
+    static QElapsedTimer window;
+    static int renders = 0;
+    if (!window.isValid()) {
+        window.start();
+    }
+    ++renders;
+    const qint64 elapsed = window.elapsed();
+    if (elapsed >= 60000) {
+        lastMinuteFullRenders = static_cast<int>(renders * 60000 / elapsed);
+        qCDebug(CHOQOK_PERF) << "Full post renders per minute:" << lastMinuteFullRenders;
+        renders = 0;
+        window.restart();
+    }
+}
+
+/**
+@return Hash of what height of document depends on, Other than width
+Timestamp text and image size are left out, The latter follows width. So patching them keeps heights.
+*/
+uint PostWidget::Private::layoutKey() const
+{
+    uint key = qHash(styleGeneration);
+    key = qHash(mProfileImage, key);
+    key = qHash(mContent, key);
+    key = qHash(mSign, key);
+    key = qHash(dir, key);
+    key = qHash(extraContents, key);
+    key = qHash(mImage.isEmpty() ? 0 : originalImage.cacheKey(), key);
+    return key;
+}
+
+bool PostWidget::Private::patchImage(QTextDocument *doc)
+{
+    if (renderedImage == mImage) {
+        return true;
+    }
+    if (renderedImage.isEmpty() || mImage.isEmpty()) {
+        // Image block is added or removed
+        return false;
+    }
+    for (QTextBlock block = doc->begin(); block.isValid(); block = block.next()) {
+        for (QTextBlock::iterator it = block.begin(); !it.atEnd(); ++it) {
+            const QTextFragment fragment = it.fragment();
+            if (!fragment.charFormat().isImageFormat()) {
+                continue;
+            }
+            QTextImageFormat format = fragment.charFormat().toImageFormat();
+            if (format.name() == resourceImageUrl) {
+                format.setWidth(imageSize.width());
+                format.setHeight(imageSize.height());
+                QTextCursor cursor(doc);
+                cursor.setPosition(fragment.position());
+                cursor.setPosition(fragment.position() + fragment.length(), QTextCursor::KeepAnchor);
+                cursor.setCharFormat(format);
+                renderedImage = mImage;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+@return Table of post template on @p doc, Or null if it's not there
+*/
+static QTextTable *templateTable(QTextDocument *doc)
+{
+    for (QTextFrame *frame: doc->rootFrame()->childFrames()) {
+        if (QTextTable *table = qobject_cast<QTextTable *>(frame)) {
+            return table;
+        }
+    }
+    return nullptr;
+}
+
+bool PostWidget::Private::patchContent(QTextDocument *doc)
+{
+    if (renderedContent == mContent) {
+        return true;
+    }
+    QTextTable *table = templateTable(doc);
+    if (!table || table->columns() < 2) {
+        return false;
+    }
+    // Content cell is made by the template of full renders, So a patched document is the same as a rendered one
+    QTextDocument rendered;
+    rendered.setHtml(baseTextTemplate.arg(QString(), mContent, QString(), dir, QString(), QString()));
+    QTextTable *renderedTable = templateTable(&rendered);
+    if (!renderedTable || renderedTable->columns() < 2) {
+        return false;
+    }
+    const QTextTableCell renderedCell = renderedTable->cellAt(0, 1);
+    QTextCursor source = renderedCell.firstCursorPosition();
+    source.setPosition(renderedCell.lastCursorPosition().position(), QTextCursor::KeepAnchor);
+
+    const QTextTableCell cell = table->cellAt(0, 1);
+    QTextCursor cursor = cell.firstCursorPosition();
+    cursor.setPosition(cell.lastCursorPosition().position(), QTextCursor::KeepAnchor);
+    cursor.insertFragment(source.selection());
+    renderedContent = mContent;
+    return true;
+}
+
+bool PostWidget::Private::patchTimestamp(QTextDocument *doc, const QString &newTimeText)
+{
+    if (timeText == newTimeText) {
+        return true;
+    }
+    if (timeCursor.document() != doc || !timeCursor.hasSelection()) {
+        return false;
+    }
+    // Replacing the selection keeps the character format of the link around it
+    const int start = timeCursor.selectionStart();
+    timeCursor.insertText(newTimeText);
+    timeCursor.setPosition(start);
+    timeCursor.setPosition(start + newTimeText.length(), QTextCursor::KeepAnchor);
+    timeText = newTimeText;
+    return true;
+}
+
+/**
+Replaces placeholder of a fresh render with @p newTimeText and records where it is
+Sign is on the last cell, Searching from there no text of post can match.
+*/
+bool PostWidget::Private::markTimestamp(QTextDocument *doc, const QString &newTimeText)
+{
+    QTextCursor from(doc);
+    if (QTextTable *table = templateTable(doc)) {
+        from = table->cellAt(table->rows() - 1, table->columns() - 1).firstCursorPosition();
+    }
+    timeCursor = doc->find(QString(timePlaceholder), from, QTextDocument::FindCaseSensitively);
+    if (timeCursor.isNull()) {
+        timeText.clear();
+        return false;
+    }
+    timeText = QString(timePlaceholder);
+    return patchTimestamp(doc, newTimeText);
+}
+
 const QString mImageTemplate(QLatin1String("<div style=\"padding-top:5px;padding-bottom:3px;\"><img width=\"%1\" height=\"%2\" src=\"%3\"/></div>"));
 
 const QLatin1String PostWidget::Private::resourceImageUrl("img://postImage");
 
+// A private use character, Which doesn't show up in signs
+const QChar PostWidget::Private::timePlaceholder(0xE000);
+
 const QString PostWidget::baseTextTemplate(QLatin1String("<table height=\"100%\" width=\"100%\"><tr><td width=\"48\" style=\"padding-right: 5px;\">%1</td><td dir=\"%4\" style=\"padding-right:3px;\"><p>%2</p></td></tr>%5%6<tr><td></td><td style=\"font-size:small;\" dir=\"ltr\" align=\"right\" valign=\"bottom\">%3</td></tr></table>"));
 
 const QString PostWidget::baseStyle(QLatin1String("QTextBrowser {border: 1px solid rgb(150,150,150);\
@@ -96,8 +343,6 @@ QPushButton{border:0px} QPushButton::menu-indicator{image:none;}"));
 
 const QString PostWidget::hrefTemplate(QLatin1String("<a href='%1' title='%1' target='_blank'>%2</a>"));
 
-const QRegExp PostWidget::dirRegExp(QLatin1String("(RT|RD)|(@([^\\s\\W]+))|(#([^\\s\\W]+))|(!([^\\s\\W]+))"));
-
 QString PostWidget::readStyle;
 QString PostWidget::unreadStyle;
 QString PostWidget::ownStyle;
@@ -111,8 +356,6 @@ PostWidget::PostWidget(Account *account, Choqok::Post *post, QWidget *parent/* =
     if (isOwnPost()) {
         d->mCurrentPost->isRead = true;
     }
-    d->mTimer.start(_MINUTE);
-    connect(&d->mTimer, &QTimer::timeout, this, &PostWidget::updateUi);
     connect(_mainWidget, &TextBrowser::clicked, this, &PostWidget::mousePressEvent);
     connect(_mainWidget, &TextBrowser::anchorClicked, this, &PostWidget::checkAnchor);
 
@@ -135,6 +378,7 @@ void PostWidget::checkAnchor(const QUrl &url)
 
 PostWidget::~PostWidget()
 {
+    RelativeTimeScheduler::self()->unschedule(this);
     if (d->mCurrentPost->owners < 2) {
         delete d->mCurrentPost;
     } else {
@@ -214,15 +458,18 @@ void PostWidget::initUi()
     }
 
     d->mProfileImage = QLatin1String("<img src=\"img://profileImage\" title=\"") + d->mCurrentPost->author.realName + QLatin1String("\" width=\"48\" height=\"48\" />");
-    d->mContent = prepareStatus(d->mCurrentPost->content);
+    if (prepareContent()) {
+        d->mContent = Private::decorateContent(d->mContent);
+    } else {
+        d->mContent = Private::decorateContent(removeTags(d->mCurrentPost->content));
+        d->pendingContent = d->mContent;
+    }
     d->mSign = generateSign();
     setupAvatar();
     fetchImage();
-    d->dir = getDirection(d->mCurrentPost->content);
+    d->dir = getDirection(d->mCurrentPost);
     setUiStyle();
 
-    d->mContent.replace(QLatin1String("<a href"), QLatin1String("<a style=\"text-decoration:none\" href"), Qt::CaseInsensitive);
-    d->mContent.replace(QLatin1String("\n"), QLatin1String("<br/>"));
     d->extraContents.replace(QLatin1String("<a href"), QLatin1String("<a style=\"text-decoration:none\" href"), Qt::CaseInsensitive);
     d->mSign.replace(QLatin1String("<a href"), QLatin1String("<a style=\"text-decoration:none\" href"), Qt::CaseInsensitive);
 
@@ -231,29 +478,134 @@ void PostWidget::initUi()
 
 void PostWidget::updateUi()
 {
-    QDateTime time;
-    if (currentPost()->repeatedDateTime.isNull()) {
-        time = currentPost()->creationDateTime;
-    } else {
-        time = currentPost()->repeatedDateTime;
+    if (!d->realized) {
+        d->renderPending = true;
+        return;
+    }
+    d->renderPending = false;
+    d->timestampStale = false;
+
+    const QDateTime time = postDateTime();
+    const QString timeText = formatDateTime(time);
+    RelativeTimeScheduler::self()->schedule(this, RelativeTimeScheduler::nextBoundary(time));
+
+    QTextDocument *doc = _mainWidget->document();
+    // Each patch changes document, Height is measured once for all of them
+    d->rendering = true;
+    if (d->hasRendered && d->renderedProfileImage == d->mProfileImage && d->renderedSign == d->mSign &&
+            d->renderedDir == d->dir && d->renderedExtraContents == d->extraContents &&
+            d->patchImage(doc) && d->patchContent(doc) && d->patchTimestamp(doc, timeText)) {
+        d->rendering = false;
+        setHeight();
+        // Resources (e.g. avatar) may have changed too
+        _mainWidget->viewport()->update();
+        return;
     }
 
     _mainWidget->setHtml(baseTextTemplate.arg( d->mProfileImage,                     /*1*/
                                                d->mContent,                          /*2*/
-                                               d->mSign.arg(formatDateTime(time)),   /*3*/
+                                               d->mSign.arg(Private::timePlaceholder), /*3*/
                                                d->dir,                               /*4*/
                                                d->mImage,                            /*5*/
                                                d->extraContents                      /*6*/
                                                ));
+    countFullRender();
+    d->hasRendered = true;
+    d->renderedProfileImage = d->mProfileImage;
+    d->renderedContent = d->mContent;
+    d->renderedSign = d->mSign;
+    d->renderedDir = d->dir;
+    d->renderedImage = d->mImage;
+    d->renderedExtraContents = d->extraContents;
+    if (!d->markTimestamp(doc, timeText)) {
+        qCDebug(CHOQOK) << "No timestamp on sign of post" << d->mCurrentPost->postId;
+    }
+    d->rendering = false;
+    setHeight();
+}
+
+int PostWidget::fullRendersPerMinute()
+{
+    return lastMinuteFullRenders;
+}
+
+void PostWidget::updateTimestamp()
+{
+    if (!d->realized || !isVisible()) {
+        // Will update on next show or realization
+        d->timestampStale = true;
+        return;
+    }
+    d->timestampStale = false;
+
+    const QDateTime time = postDateTime();
+    const QString timeText = formatDateTime(time);
+    RelativeTimeScheduler::self()->schedule(this, RelativeTimeScheduler::nextBoundary(time));
+    if (!d->hasRendered || !d->patchTimestamp(_mainWidget->document(), timeText)) {
+        updateUi();
+    }
+}
+
+QDateTime PostWidget::postDateTime() const
+{
+    if (currentPost()->repeatedDateTime.isNull()) {
+        return currentPost()->creationDateTime;
+    } else {
+        return currentPost()->repeatedDateTime;
+    }
 }
 
 void PostWidget::setStyle(const QColor &color, const QColor &back, const QColor &read, const QColor &readBack, const QColor &own, const QColor &ownBack, const QFont &font)
 {
+    ++styleGeneration;
     QString fntStr = QLatin1String("font-family:\"") + font.family() + QLatin1String("\"; font-size:") + QString::number(font.pointSize()) + QLatin1String("pt;");
     fntStr += (font.bold() ? QLatin1String(" font-weight:bold;") : QString()) + (font.italic() ? QLatin1String(" font-style:italic;") : QString());
     unreadStyle = baseStyle.arg(getColorString(color), getColorString(back), fntStr);
     readStyle = baseStyle.arg(getColorString(read), getColorString(readBack), fntStr);
     ownStyle = baseStyle.arg(getColorString(own), getColorString(ownBack), fntStr);
+
+    unreadBackColor = back;
+    readBackColor = readBack;
+    ownBackColor = ownBack;
+
+    const QString stateStyle(QLatin1String("Choqok--UI--PostWidget[postState=\"%1\"] QTextBrowser {color:%2; background-color:%3; %4}\n"));
+    postsStyle = QLatin1String("Choqok--UI--PostWidget QTextBrowser {border: 1px solid rgb(150,150,150); border-radius:5px;}\n");
+    postsStyle += stateStyle.arg(QLatin1String("unread"), getColorString(color), getColorString(back), fntStr);
+    postsStyle += stateStyle.arg(QLatin1String("read"), getColorString(read), getColorString(readBack), fntStr);
+    postsStyle += stateStyle.arg(QLatin1String("own"), getColorString(own), getColorString(ownBack), fntStr);
+    postsStyle += QLatin1String("Choqok--UI--PostWidget[highlighted=\"true\"] QTextBrowser {border: 2px solid rgb(255,0,0);}\n"
+                                "Choqok--UI--PostWidget QPushButton{border:0px} "
+                                "Choqok--UI--PostWidget QPushButton::menu-indicator{image:none;}");
+}
+
+QString PostWidget::postsStyleSheet()
+{
+    return postsStyle;
+}
+
+void PostWidget::setHighlighted(bool highlighted)
+{
+    if (isHighlighted() != highlighted) {
+        setProperty(highlightedProperty.latin1(), highlighted);
+        repolish(_mainWidget);
+    }
+}
+
+bool PostWidget::isHighlighted() const
+{
+    return property(highlightedProperty.latin1()).toBool();
+}
+
+QColor PostWidget::backgroundColor() const
+{
+    const QString state = property(stateProperty.latin1()).toString();
+    if (state == QLatin1String("own")) {
+        return ownBackColor;
+    } else if (state == QLatin1String("read")) {
+        return readBackColor;
+    } else {
+        return unreadBackColor;
+    }
 }
 
 QPushButton *PostWidget::addButton(const QString &objName, const QString &toolTip, const QString &icon)
@@ -316,14 +668,23 @@ bool PostWidget::isRead() const
 
 void PostWidget::setUiStyle()
 {
+    QLatin1String state("unread");
     if (isOwnPost()) {
-        setStyleSheet(ownStyle);
-    } else {
-        if (currentPost()->isRead) {
-            setStyleSheet(readStyle);
-        } else {
-            setStyleSheet(unreadStyle);
-        }
+        state = QLatin1String("own");
+    } else if (currentPost()->isRead) {
+        state = QLatin1String("read");
+    }
+    const bool changed = property(stateProperty.latin1()).toString() != state;
+    if (changed) {
+        setProperty(stateProperty.latin1(), QString(state));
+    }
+
+    if (!d->timeline && d->appliedStyleSheet != styleGeneration) {
+        // No container style sheet applies to us
+        d->appliedStyleSheet = styleGeneration;
+        setStyleSheet(postsStyle);
+    } else if (changed) {
+        repolish(_mainWidget);
     }
     setHeight();
 }
@@ -335,11 +696,64 @@ bool PostWidget::isOwnPost()
 
 void PostWidget::setHeight()
 {
-    _mainWidget->document()->setTextWidth(width() - 2);
-    int h = _mainWidget->document()->size().toSize().height() + 2;
+    if (!d->realized || d->rendering) {
+        return;
+    }
+    QTextDocument *doc = _mainWidget->document();
+    const uint key = d->layoutKey();
+    if (d->heightsKey != key) {
+        d->heights.clear();
+        d->heightsKey = key;
+    }
+    const int textWidth = width() - 2;
+    auto it = d->heights.constFind(textWidth);
+    if (it != d->heights.constEnd()) {
+        setFixedHeight(it.value());
+        return;
+    }
+    doc->setTextWidth(textWidth);
+    int h = doc->size().toSize().height() + 2;
+    d->heights.insert(textWidth, h);
     setFixedHeight(h);
 }
 
+qint64 PostWidget::memoryUsage() const
+{
+    qint64 bytes = sizeof(PostWidget) + sizeof(Private) + sizeof(Post);
+    bytes += sizeof(QChar) * (d->mCurrentPost->content.size() + d->mContent.size() + d->mSign.size() +
+                              d->mImage.size() + d->extraContents.size());
+    bytes += pixmapBytes(d->originalImage);
+    for (const QPixmap &pixmap: d->scaledImages) {
+        bytes += pixmapBytes(pixmap);
+    }
+    if (d->realized && d->hasRendered) {
+        bytes += RenderedDocumentBytes;
+    }
+    return bytes;
+}
+
+void PostWidget::relayout()
+{
+    if (d->laidOutWidth == width()) {
+        return;
+    }
+    if (!d->realized) {
+        // Height for this width is known if post was shown at it before, Otherwise it's measured on realization
+        if (d->heightsKey == d->layoutKey()) {
+            auto it = d->heights.constFind(width() - 2);
+            if (it != d->heights.constEnd()) {
+                setFixedHeight(it.value());
+            }
+        }
+        return;
+    }
+    d->laidOutWidth = width();
+    updatePostImage(width());
+    // Image is resized on document before measuring
+    updateUi();
+    setHeight();
+}
+
 void PostWidget::closeEvent(QCloseEvent *event)
 {
     clearFocus();
@@ -347,6 +761,10 @@ void PostWidget::closeEvent(QCloseEvent *event)
         setReadWithSignal();
     }
     Q_EMIT aboutClosing(currentPost()->postId, this);
+    MediaManager::self()->cancelImageFetch(d->mCurrentPost->author.profileImageUrl, this);
+    if (!d->imageUrl.isEmpty()) {
+        MediaManager::self()->cancelImageFetch(d->imageUrl, this);
+    }
     event->accept();
 }
 
@@ -360,10 +778,24 @@ void PostWidget::mousePressEvent(QMouseEvent *ev)
 
 void PostWidget::resizeEvent(QResizeEvent *event)
 {
-    updatePostImage( event->size().width() );
-    setHeight();
-    updateUi();
     QWidget::resizeEvent(event);
+    if (event->oldSize().width() == event->size().width()) {
+        // Height changes come from setHeight() itself
+        return;
+    }
+    if (d->timeline) {
+        d->timeline->schedulePostsRelayout();
+    } else {
+        relayout();
+    }
+}
+
+void PostWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (d->timestampStale) {
+        updateTimestamp();
+    }
 }
 
 void PostWidget::enterEvent(QEvent *event)
@@ -389,10 +821,25 @@ void PostWidget::leaveEvent(QEvent *event)
 void PostWidget::updatePostImage(int width)
 {
     if ( !d->originalImage.isNull() ) {
-        // TODO: Find a way to calculate the difference we need to subtract.
-        width -= 76;
-        
-        QPixmap newPixmap = d->originalImage.scaledToWidth(width, Qt::SmoothTransformation);
+        width -= ImageMargin;
+
+        const int bucket = qMax(ImageWidthBucket, width - width % ImageWidthBucket);
+        QPixmap newPixmap;
+        auto cached = d->scaledImages.constFind(bucket);
+        if (cached != d->scaledImages.constEnd()) {
+            newPixmap = cached.value();
+            d->scaledImagesOrder.removeOne(bucket);
+            d->scaledImagesOrder.append(bucket);
+        } else if (bucket < d->originalImage.width()) {
+            if (d->scaledImages.count() >= MaxScaledImages) {
+                d->scaledImages.remove(d->scaledImagesOrder.takeFirst());
+            }
+            newPixmap = MediaManager::self()->scaledImage(d->imageUrl, d->originalImage, bucket);
+            d->scaledImages.insert(bucket, newPixmap);
+            d->scaledImagesOrder.append(bucket);
+        } else {
+            newPixmap = d->originalImage;
+        }
         auto newW = newPixmap.width();
         auto newH = newPixmap.height();
         auto origW = d->originalImage.width();
@@ -402,9 +849,11 @@ void PostWidget::updatePostImage(int width)
         // only use scaled image if it's smaller than the original one
         if (newW <= origW && newH <= origH) { // never scale up
             d->mImage = mImageTemplate.arg(QString::number(newW), QString::number(newH), d->resourceImageUrl);
+            d->imageSize = QSize(newW, newH);
             _mainWidget->document()->addResource(QTextDocument::ImageResource, url, newPixmap);
         } else {
             d->mImage = mImageTemplate.arg(QString::number(origW), QString::number(origH), d->resourceImageUrl);
+            d->imageSize = QSize(origW, origH);
             _mainWidget->document()->addResource(QTextDocument::ImageResource, url, d->originalImage);
         }
     }
@@ -412,26 +861,72 @@ void PostWidget::updatePostImage(int width)
 
 QString PostWidget::prepareStatus(const QString &txt)
 {
-    QString text = removeTags(txt);
+    // Usually linkified on worker thread already
+    const PreparedContent linked = ContentPreparer::self()->linkified(txt);
+    d->detectedUrls = linked.urls();
+    QString text = linked.html();
 
-    d->detectedUrls = UrlUtils::detectUrls(text);
-    for (const QString &url: d->detectedUrls) {
-        QString httpUrl(url);
-        if (!httpUrl.startsWith(QLatin1String("http"), Qt::CaseInsensitive) &&
-                !httpUrl.startsWith(QLatin1String("ftp"), Qt::CaseInsensitive)) {
-            httpUrl.prepend(QLatin1String("http://"));
-            text.replace(url, httpUrl);
-        }
-
-        text.replace(url, hrefTemplate.arg(httpUrl, url));
+    if (AppearanceSettings::isEmoticonsEnabled()) {
+        text = MediaManager::self()->parseEmoticons(text);
     }
 
-    text = UrlUtils::detectEmails(text);
+    return text;
+}
 
-    if (AppearanceSettings::isEmoticonsEnabled()) {
-        text = MediaManager::self()->parseEmoticons(text);
+bool PostWidget::prepareContent()
+{
+    const QString &content = d->mCurrentPost->content;
+    const QString key = ContentPreparer::contentKey(d->mCurrentAccount->alias(), d->mCurrentPost->postId,
+                                                    content, this);
+    const PreparedContent cached = ContentPreparer::self()->content(key);
+    if (!cached.isNull()) {
+        d->mContent = cached.html();
+        d->detectedUrls = cached.urls();
+        return true;
+    }
+    if (!ContentPreparer::self()->prepare(content, this, "slotContentPrepared")) {
+        return false;
     }
+    d->mContent = prepareStatus(content);
+    ContentPreparer::self()->insertContent(key, PreparedContent(d->mContent, d->detectedUrls));
+    return true;
+}
 
+void PostWidget::slotContentPrepared()
+{
+    if (d->pendingContent.isEmpty()) {
+        return;
+    }
+    const QString current = d->mContent;
+    if (!prepareContent()) {
+        // Linkified text is dropped from cache meanwhile, And queued again
+        return;
+    }
+    const QString prepared = Private::decorateContent(d->mContent);
+    // Content may be changed meanwhile, e.g. By a base post prepended. Changes around plain text are kept.
+    if (current == d->pendingContent) {
+        d->mContent = prepared;
+    } else if (current.contains(d->pendingContent)) {
+        d->mContent = QString(current).replace(d->pendingContent, prepared);
+    } else {
+        d->mContent = current;
+        qCDebug(CHOQOK) << "Content of" << d->mCurrentPost->postId << "is replaced before it's prepared";
+    }
+    d->pendingContent.clear();
+    updateUi();
+    Q_EMIT contentPrepared();
+}
+
+bool PostWidget::isContentPending() const
+{
+    return !d->pendingContent.isEmpty();
+}
+
+QString PostWidget::Private::decorateContent(const QString &content)
+{
+    QString text(content);
+    text.replace(QLatin1String("<a href"), QLatin1String("<a style=\"text-decoration:none\" href"), Qt::CaseInsensitive);
+    text.replace(QLatin1String("\n"), QLatin1String("<br/>"));
     return text;
 }
 
@@ -444,14 +939,23 @@ QString PostWidget::removeTags(const QString &text) const
 
     return txt;
 }
-QLatin1String PostWidget::getDirection(QString txt)
+QLatin1String PostWidget::getDirection(const QString &text)
 {
-    txt.remove(dirRegExp);
-    txt = txt.trimmed();
-    if (txt.isRightToLeft()) {
+    if (Choqok::textDirection(text) == Qt::RightToLeft) {
         return QLatin1String("rtl");
+    } else {
+        return QLatin1String("ltr");
     }
-    else {
+}
+
+QLatin1String PostWidget::getDirection(Choqok::Post *post)
+{
+    if (post->direction == Qt::LayoutDirectionAuto) {
+        post->direction = Choqok::textDirection(post->content);
+    }
+    if (post->direction == Qt::RightToLeft) {
+        return QLatin1String("rtl");
+    } else {
         return QLatin1String("ltr");
     }
 }
@@ -463,28 +967,24 @@ QString PostWidget::formatDateTime(const QDateTime &time)
     }
     auto seconds = time.secsTo(QDateTime::currentDateTime());
     if (seconds <= 15) {
-        d->mTimer.setInterval(_15SECS);
         return i18n("Just now");
     }
 
     if (seconds <= 45) {
-        d->mTimer.setInterval(_15SECS);
-        return i18np("1 sec ago", "%1 secs ago", seconds);
+        // In steps of 15 seconds, As often as RelativeTimeScheduler updates it
+        return i18np("1 sec ago", "%1 secs ago", (seconds - 1) / 15 * 15);
     }
 
     auto minutes = (seconds - 45 + 59) / 60;
     if (minutes <= 45) {
-        d->mTimer.setInterval(_MINUTE);
         return i18np("1 min ago", "%1 mins ago", minutes);
     }
 
     auto hours = (seconds - 45 * 60 + 3599) / 3600;
     if (hours <= 18) {
-        d->mTimer.setInterval(_MINUTE * 15);
         return i18np("1 hour ago", "%1 hours ago", hours);
     }
 
-    d->mTimer.setInterval(_HOUR);
     auto days = (seconds - 18 * 3600 + 24 * 3600 - 1) / (24 * 3600);
     return i18np("1 day ago", "%1 days ago", days);
 }
@@ -534,21 +1034,22 @@ void PostWidget::fetchImage()
         return;
     }
 
-    QPixmap pix = MediaManager::self()->fetchImage(d->imageUrl, MediaManager::Async);
+    // Post images are never shown wider than the screen
+    const QSize maxSize(QGuiApplication::primaryScreen()->availableSize().width(), QWIDGETSIZE_MAX);
+    QPixmap pix = MediaManager::self()->fetchImage(d->imageUrl, this, "slotImageFetched", nullptr, maxSize,
+                                                   d->fetchPriority());
 
     if (!pix.isNull()) {
         slotImageFetched(d->imageUrl, pix);
-    } else {
-        connect(MediaManager::self(), &MediaManager::imageFetched, this,
-                &PostWidget::slotImageFetched);
     }
 }
 
 void PostWidget::slotImageFetched(const QUrl &remoteUrl, const QPixmap &pixmap)
 {
     if (remoteUrl == d->imageUrl) {
-        disconnect(MediaManager::self(), &MediaManager::imageFetched, this, &PostWidget::slotImageFetched);
         d->originalImage = pixmap;
+        d->scaledImages.clear();
+        d->scaledImagesOrder.clear();
         updatePostImage( width() );
         updateUi();
     }
@@ -557,12 +1058,10 @@ void PostWidget::slotImageFetched(const QUrl &remoteUrl, const QPixmap &pixmap)
 void PostWidget::setupAvatar()
 {
     QPixmap pix = MediaManager::self()->fetchImage(d->mCurrentPost->author.profileImageUrl,
-                  MediaManager::Async);
+                  this, "avatarFetched", "avatarFetchError", QSize(AvatarSize, AvatarSize),
+                  d->fetchPriority());
     if (!pix.isNull()) {
         avatarFetched(d->mCurrentPost->author.profileImageUrl, pix);
-    } else {
-        connect(MediaManager::self(), &MediaManager::imageFetched, this, &PostWidget::avatarFetched);
-        connect(MediaManager::self(), &MediaManager::fetchError, this, &PostWidget::avatarFetchError);
     }
 }
 
@@ -572,8 +1071,6 @@ void PostWidget::avatarFetched(const QUrl &remoteUrl, const QPixmap &pixmap)
         const QUrl url(QLatin1String("img://profileImage"));
         _mainWidget->document()->addResource(QTextDocument::ImageResource, url, pixmap);
         updateUi();
-        disconnect(MediaManager::self(), &MediaManager::imageFetched, this, &PostWidget::avatarFetched);
-        disconnect(MediaManager::self(), &MediaManager::fetchError, this, &PostWidget::avatarFetchError);
     }
 }
 
@@ -581,7 +1078,7 @@ void PostWidget::avatarFetchError(const QUrl &remoteUrl, const QString &errMsg)
 {
     Q_UNUSED(errMsg);
     if (remoteUrl == d->mCurrentPost->author.profileImageUrl) {
-        ///Avatar fetching is failed! but will not disconnect to get the img if it fetches later!
+        ///Avatar fetching is failed!
         const QUrl url(QLatin1String("img://profileImage"));
         _mainWidget->document()->addResource(QTextDocument::ImageResource,
                                              url, QIcon::fromTheme(QLatin1String("image-missing")).pixmap(48));
@@ -699,6 +1196,37 @@ void PostWidgetUserData::setPostWidget(PostWidget *widget)
     d->postWidget = widget;
 }
 
+void PostWidget::setRealized(bool realized)
+{
+    if (d->realized == realized) {
+        return;
+    }
+    d->realized = realized;
+    if (realized) {
+        if (d->renderPending) {
+            updateUi();
+        } else if (d->timestampStale) {
+            updateTimestamp();
+        }
+        relayout();
+        const MediaManager::FetchPriority priority = d->fetchPriority();
+        MediaManager::self()->setImageFetchPriority(d->mCurrentPost->author.profileImageUrl, priority);
+        if (!d->imageUrl.isEmpty()) {
+            MediaManager::self()->setImageFetchPriority(d->imageUrl, priority);
+        }
+    } else {
+        // Height is kept fixed by setHeight() guard, So timeline layout won't change
+        d->renderPending = true;
+        d->hasRendered = false;
+        _mainWidget->document()->setHtml(QString());
+    }
+}
+
+bool PostWidget::isRealized() const
+{
+    return d->realized;
+}
+
 QString PostWidget::getBaseStyle()
 {
     return baseStyle;
@@ -72,6 +72,7 @@ public:
     Set stylesheet data with new color data! to use later.
 
     @see setUiStyle()
+    @see postsStyleSheet()
     */
     static void setStyle(const QColor &unreadColor, const QColor &unreadBack,
                          const QColor &readColor, const QColor &readBack,
@@ -127,13 +128,78 @@ public:
 
     static QString getBaseStyle();
 
+    /**
+    @return Style sheet of all PostWidgets, generated by @ref setStyle()
+    Containers of posts (i.e. TimelineWidget) set it once. Each post then only changes its "postState"
+    ("unread", "read" or "own") and "highlighted" dynamic properties, which is a cheap repolish of its
+    text browser instead of parsing a style sheet per widget.
+    */
+    static QString postsStyleSheet();
+
+    /**
+    Mark this post with a highlighted border, Used by filters
+    */
+    void setHighlighted(bool highlighted);
+    bool isHighlighted() const;
+
+    /**
+    @return Background color of current state of post
+    */
+    QColor backgroundColor() const;
+
+    /**
+    @return Count of full post document renders (HTML parse and layout) in the last measured minute
+    Patched updates of timestamp, avatar, image size and content are not counted.
+    */
+    static int fullRendersPerMinute();
+
+    /**
+    @brief Keep or release the rendered document of this post
+
+    TimelineWidget only keeps the posts near its viewport realized.
+    An unrealized post keeps its last height, and defers @ref updateUi() until it gets realized again.
+    */
+    void setRealized(bool realized);
+
+    /**
+    @return true if the document of this post is rendered
+    */
+    bool isRealized() const;
+
+    /**
+    @brief Apply a width change of widget
+    Rescale the post image, and update height of widget. Does nothing if width is not changed since last call.
+    An unrealized post only takes a height it had at this width before, And is measured when it gets realized.
+    TimelineWidget calls this once for a series of resize events.
+    */
+    void relayout();
+
+    /**
+    @return true if content is being prepared on worker thread, @ref contentPrepared() is emitted then
+    Until that @ref content() is plain text, And @ref urls() is empty.
+    */
+    bool isContentPending() const;
+
+    /**
+    @return Rough estimation of memory used by this post, in bytes
+    Includes texts, images and the rendered document if widget is realized.
+    */
+    qint64 memoryUsage() const;
+
 public Q_SLOTS:
     /**
-    Set Style sheet of widget to corresponding data->
+    Set "postState" property of widget to corresponding data->
     @see setStyle()
+    @see postsStyleSheet()
     */
     void setUiStyle();
 
+    /**
+    Update the relative timestamp text of post, without a full re-render
+    Called by @ref RelativeTimeScheduler when the timestamp text changes
+    */
+    virtual void updateTimestamp();
+
 Q_SIGNALS:
     /**
     Emit and contain text to resend.
@@ -154,6 +220,16 @@ Q_SIGNALS:
     */
     void aboutClosing(const QString &postId, PostWidget *widget);
 
+    /**
+    Emit when fields of current post change in place, e.g. It gets favorited. So timeline saves it.
+    */
+    void postChanged();
+
+    /**
+    Emitted when content which was pending on worker thread is set. @see isContentPending()
+    */
+    void contentPrepared();
+
 protected Q_SLOTS:
 
     virtual void checkAnchor(const QUrl &url);
@@ -184,6 +260,11 @@ protected Q_SLOTS:
                                Choqok::MicroBlog::ErrorType error, const QString &errorMessage);
 
     void avatarFetchError(const QUrl &remoteUrl, const QString &errMsg);
+
+    /**
+    Called by @ref ContentPreparer when content of post is linkified on worker thread
+    */
+    void slotContentPrepared();
     void avatarFetched(const QUrl &remoteUrl, const QPixmap &pixmap);
 
     void slotImageFetched(const QUrl &remoteUrl, const QPixmap &pixmap);
@@ -196,12 +277,21 @@ protected:
     virtual void fetchImage();
     virtual void wheelEvent(QWheelEvent *) override;
     virtual void resizeEvent(QResizeEvent *event) override;
+    virtual void showEvent(QShowEvent *event) override;
     virtual void enterEvent(QEvent *event) override;
     virtual void leaveEvent(QEvent *event) override;
     virtual QString prepareStatus(const QString &text);
-    QLatin1String getDirection(QString text);
+    QLatin1String getDirection(const QString &text);
+    /**
+    @return "rtl" or "ltr" for content of @p post, Detects and stores direction of @p post if it's not known yet
+    */
+    static QLatin1String getDirection(Choqok::Post *post);
     virtual QString generateSign();
     virtual QString formatDateTime(const QDateTime &time);
+    /**
+    @return Time of post to show on sign, i.e. repeat time for repeated posts
+    */
+    QDateTime postDateTime() const;
     virtual bool isResendAvailable() ;
     virtual bool isRemoveAvailable() ;
     virtual bool isOwnPost();
@@ -226,7 +316,6 @@ protected:
     static const QString webIconText;
     static const QString hrefTemplate;
     static const QString baseTextTemplate;
-    static const QRegExp dirRegExp;
 
     void setAvatarText(const QString &text);
     QString avatarText() const;
@@ -236,6 +325,12 @@ protected:
     void updatePostImage(int width);
 
 private:
+    /**
+    Set content to prepared content of current post, from cache or by @ref prepareStatus()
+    @return false if content is queued on worker thread, @ref slotContentPrepared() is called later
+    */
+    bool prepareContent();
+
     class Private;
     Private *const d;
 };
@@ -0,0 +1,194 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+#include "relativetimescheduler.h"
+
+#include <QApplication>
+#include <QEvent>
+#include <QHash>
+#include <QMultiMap>
+#include <QTimer>
+
+#include "choqokmainwindow.h"
+#include "choqokuiglobal.h"
+#include "postwidget.h"
+
+static const qint64 _SECOND = 1000;
+static const qint64 _MINUTE = 60 * _SECOND;
+static const qint64 _HOUR = 60 * _MINUTE;
+static const qint64 _DAY = 24 * _HOUR;
+
+namespace Choqok
+{
+namespace UI
+{
+
+class RelativeTimeScheduler::Private
+{
+public:
+    Private()
+        : watchedWindow(nullptr), paused(false), armedAt(0)
+    {}
+    QMultiMap<qint64, PostWidget *> queue; // <Boundary in msecs since epoch, Widget>
+    QHash<PostWidget *, qint64> boundaries;
+    QTimer timer;
+    QObject *watchedWindow;
+    bool paused;
+    qint64 armedAt;
+};
+
+RelativeTimeScheduler *RelativeTimeScheduler::mSelf = nullptr;
+
+RelativeTimeScheduler::RelativeTimeScheduler()
+    : QObject(qApp), d(new Private)
+{
+    d->timer.setSingleShot(true);
+    connect(&d->timer, &QTimer::timeout, this, &RelativeTimeScheduler::slotTimeout);
+}
+
+RelativeTimeScheduler::~RelativeTimeScheduler()
+{
+    delete d;
+    mSelf = nullptr;
+}
+
+RelativeTimeScheduler *RelativeTimeScheduler::self()
+{
+    if (!mSelf) {
+        mSelf = new RelativeTimeScheduler;
+    }
+    return mSelf;
+}
+
+void RelativeTimeScheduler::schedule(PostWidget *widget, const QDateTime &boundary)
+{
+    unschedule(widget);
+    if (!boundary.isValid()) {
+        return;
+    }
+
+    // Round up to a granularity related to distance, So nearby boundaries share one tick
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 key = boundary.toMSecsSinceEpoch();
+    const qint64 distance = key - now;
+    qint64 granularity;
+    if (distance < _MINUTE) {
+        granularity = _SECOND;
+    } else if (distance < _HOUR) {
+        granularity = 5 * _SECOND;
+    } else if (distance < _DAY) {
+        granularity = _MINUTE;
+    } else {
+        granularity = 10 * _MINUTE;
+    }
+    key = ((key + granularity - 1) / granularity) * granularity;
+
+    d->queue.insert(key, widget);
+    d->boundaries.insert(widget, key);
+
+    Choqok::UI::MainWindow *window = Global::mainWindow();
+    if (window && d->watchedWindow != window) {
+        window->installEventFilter(this);
+        d->watchedWindow = window;
+        d->paused = !window->isVisible();
+    }
+    rearm();
+}
+
+void RelativeTimeScheduler::unschedule(PostWidget *widget)
+{
+    auto it = d->boundaries.find(widget);
+    if (it != d->boundaries.end()) {
+        d->queue.remove(it.value(), widget);
+        d->boundaries.erase(it);
+    }
+}
+
+void RelativeTimeScheduler::rearm()
+{
+    if (d->paused || d->queue.isEmpty()) {
+        d->timer.stop();
+        return;
+    }
+    const qint64 next = d->queue.firstKey();
+    if (d->timer.isActive() && d->armedAt <= next) {
+        return;
+    }
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    // Don't sleep for more than an hour, to survive system clock changes
+    const qint64 delay = qBound<qint64>(0, next - now, _HOUR);
+    d->armedAt = now + delay;
+    d->timer.start(static_cast<int>(delay));
+}
+
+void RelativeTimeScheduler::slotTimeout()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<PostWidget *> due;
+    while (!d->queue.isEmpty() && d->queue.firstKey() <= now) {
+        auto it = d->queue.begin();
+        due.append(it.value());
+        d->boundaries.remove(it.value());
+        d->queue.erase(it);
+    }
+    for (PostWidget *widget: due) {
+        widget->updateTimestamp();
+    }
+    rearm();
+}
+
+bool RelativeTimeScheduler::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == d->watchedWindow) {
+        if (event->type() == QEvent::Hide) {
+            d->paused = true;
+            d->timer.stop();
+        } else if (event->type() == QEvent::Show) {
+            d->paused = false;
+            rearm();
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+QDateTime RelativeTimeScheduler::nextBoundary(const QDateTime &time, const QDateTime &now)
+{
+    if (!time.isValid()) {
+        return QDateTime();
+    }
+    const qint64 seconds = time.secsTo(now);
+    qint64 next;
+    if (seconds <= 15) {
+        next = 16;
+    } else if (seconds <= 45) {
+        next = ((seconds - 1) / 15 + 1) * 15 + 1;
+    } else if ((seconds - 45 + 59) / 60 <= 45) {
+        next = 45 + 60 * ((seconds - 45 + 59) / 60) + 1;
+    } else if ((seconds - 45 * 60 + 3599) / 3600 <= 18) {
+        next = 45 * 60 + 3600 * ((seconds - 45 * 60 + 3599) / 3600) + 1;
+    } else {
+        next = 18 * 3600 + 24 * 3600 * ((seconds - 18 * 3600 + 24 * 3600 - 1) / (24 * 3600)) + 1;
+    }
+    return time.addSecs(next);
+}
+
+}
+}
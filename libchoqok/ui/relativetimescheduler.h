@@ -0,0 +1,90 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+#ifndef RELATIVETIMESCHEDULER_H
+#define RELATIVETIMESCHEDULER_H
+
+#include <QDateTime>
+#include <QObject>
+
+#include "choqok_export.h"
+
+namespace Choqok
+{
+namespace UI
+{
+
+class PostWidget;
+
+/**
+@brief Single ticker to refresh the relative timestamps ("3 mins ago") of posts
+
+Every PostWidget registers the time its timestamp text changes next (Its bucket boundary),
+and the scheduler arms one timer for the earliest of them. Boundaries are rounded up to a
+granularity related to their distance, So posts of a timeline usually share the same tick.
+Nothing runs while the main window is hidden.
+
+@see PostWidget::updateTimestamp()
+*/
+class CHOQOK_EXPORT RelativeTimeScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    ~RelativeTimeScheduler();
+
+    static RelativeTimeScheduler *self();
+
+    /**
+    Call @ref PostWidget::updateTimestamp() of @p widget at @p boundary
+    Any previous schedule of @p widget will be replaced.
+    */
+    void schedule(PostWidget *widget, const QDateTime &boundary);
+
+    /**
+    Remove @p widget from the scheduler
+    */
+    void unschedule(PostWidget *widget);
+
+    /**
+    @return The time when relative text of @p time will change next, related to @p now
+    This matches the buckets of @ref PostWidget::formatDateTime()
+    */
+    static QDateTime nextBoundary(const QDateTime &time, const QDateTime &now = QDateTime::currentDateTime());
+
+protected:
+    virtual bool eventFilter(QObject *watched, QEvent *event) override;
+
+protected Q_SLOTS:
+    void slotTimeout();
+
+private:
+    RelativeTimeScheduler();
+    void rearm();
+
+    class Private;
+    Private *const d;
+    static RelativeTimeScheduler *mSelf;
+};
+
+}
+}
+
+#endif // RELATIVETIMESCHEDULER_H
@@ -0,0 +1,136 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+#include "timelinemodel.h"
+
+#include "postwidget.h"
+
+namespace Choqok
+{
+namespace UI
+{
+
+class TimelineModel::Private
+{
+public:
+    QList<PostWidget *> rows;
+};
+
+TimelineModel::TimelineModel(QObject *parent)
+    : QAbstractListModel(parent), d(new Private)
+{
+}
+
+TimelineModel::~TimelineModel()
+{
+    delete d;
+}
+
+int TimelineModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return d->rows.count();
+}
+
+QVariant TimelineModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= d->rows.count()) {
+        return QVariant();
+    }
+    PostWidget *widget = d->rows.at(index.row());
+    Post *post = widget->currentPost();
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return post->content;
+    case PostRole:
+        return QVariant::fromValue(post);
+    case PostIdRole:
+        return post->postId;
+    case PostWidgetRole:
+        return QVariant::fromValue(widget);
+    case CreationDateTimeRole:
+        return post->creationDateTime;
+    case IsReadRole:
+        return post->isRead;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> TimelineModel::roleNames() const
+{
+    QHash<int, QByteArray> roles = QAbstractListModel::roleNames();
+    roles.insert(PostRole, "post");
+    roles.insert(PostIdRole, "postId");
+    roles.insert(PostWidgetRole, "postWidget");
+    roles.insert(CreationDateTimeRole, "creationDateTime");
+    roles.insert(IsReadRole, "isRead");
+    return roles;
+}
+
+void TimelineModel::insertPostWidget(int row, PostWidget *widget)
+{
+    if (row < 0 || row > d->rows.count()) {
+        row = d->rows.count();
+    }
+    beginInsertRows(QModelIndex(), row, row);
+    d->rows.insert(row, widget);
+    endInsertRows();
+}
+
+void TimelineModel::removePostWidget(PostWidget *widget)
+{
+    const int row = d->rows.indexOf(widget);
+    if (row == -1) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    d->rows.removeAt(row);
+    endRemoveRows();
+}
+
+int TimelineModel::rowOf(PostWidget *widget) const
+{
+    return d->rows.indexOf(widget);
+}
+
+PostWidget *TimelineModel::postWidget(int row) const
+{
+    if (row < 0 || row >= d->rows.count()) {
+        return nullptr;
+    }
+    return d->rows.at(row);
+}
+
+void TimelineModel::postWidgetChanged(PostWidget *widget)
+{
+    const int row = d->rows.indexOf(widget);
+    if (row != -1) {
+        const QModelIndex idx = index(row);
+        Q_EMIT dataChanged(idx, idx);
+    }
+}
+
+}
+}
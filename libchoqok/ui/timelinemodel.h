@@ -0,0 +1,101 @@
+/*
+This file is part of Choqok, the KDE micro-blogging client
+
+Copyright (C) 2020 Choqok Developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see http://www.gnu.org/licenses/
+*/
+#ifndef TIMELINEMODEL_H
+#define TIMELINEMODEL_H
+
+#include <QAbstractListModel>
+
+#include "choqok_export.h"
+#include "choqoktypes.h"
+
+namespace Choqok
+{
+namespace UI
+{
+
+class PostWidget;
+
+/**
+@brief List model of the posts shown on a @ref TimelineWidget
+
+Rows are kept in the same order they are laid out on the timeline, so a row index
+maps directly to a vertical position. Every row is backed by a @ref PostWidget which acts as the
+renderer of that row. TimelineWidget uses the model to find the rows near the viewport and only
+keeps those realized.
+
+@see PostWidget::setRealized()
+*/
+class CHOQOK_EXPORT TimelineModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Roles {
+        PostRole = Qt::UserRole + 1,
+        PostIdRole,
+        PostWidgetRole,
+        CreationDateTimeRole,
+        IsReadRole
+    };
+
+    explicit TimelineModel(QObject *parent = nullptr);
+    virtual ~TimelineModel();
+
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    virtual QHash<int, QByteArray> roleNames() const override;
+
+    /**
+    Insert @p widget at @p row, a negative @p row appends it to the end of model.
+    */
+    void insertPostWidget(int row, PostWidget *widget);
+
+    /**
+    Remove the row of @p widget, if any.
+    */
+    void removePostWidget(PostWidget *widget);
+
+    /**
+    @return Row of @p widget or -1 if it's not on this model.
+    */
+    int rowOf(PostWidget *widget) const;
+
+    /**
+    @return PostWidget of @p row or nullptr for an invalid row.
+    */
+    PostWidget *postWidget(int row) const;
+
+    /**
+    Emit dataChanged() for the row of @p widget, Useful when post read state changed.
+    */
+    void postWidgetChanged(PostWidget *widget);
+
+private:
+    class Private;
+    Private *const d;
+};
+
+}
+}
+
+Q_DECLARE_METATYPE(Choqok::Post *)
+
+#endif // TIMELINEMODEL_H
@@ -21,22 +21,33 @@ along with this program; if not, see http://www.gnu.org/licenses/
 */
 #include "timelinewidget.h"
 
+#include <QEvent>
+#include <QHash>
 #include <QLabel>
 #include <QPointer>
 #include <QPushButton>
 #include <QScrollArea>
 #include <QScrollBar>
+#include <QSet>
 #include <QTextDocument>
 #include <QTimer>
 #include <QVBoxLayout>
+#include <QVector>
+
+#include <KFormat>
+
+#include <algorithm>
 
 #include "account.h"
+#include "application.h"
 #include "choqokappearancesettings.h"
 #include "choqokbehaviorsettings.h"
 #include "libchoqokdebug.h"
 #include "microblog.h"
 #include "postwidget.h"
 #include "notifymanager.h"
+#include "searchindex.h"
+#include "timelinemodel.h"
 
 namespace Choqok
 {
@@ -48,7 +59,9 @@ class TimelineWidget::Private
 public:
     Private(Account *account, const QString &timelineName)
         : currentAccount(account), timelineName(timelineName),
-          btnMarkAllAsRead(nullptr), unreadCount(0), placeholderLabel(nullptr), info(nullptr), isClosable(false)
+          btnMarkAllAsRead(nullptr), unreadCount(0), placeholderLabel(nullptr), info(nullptr), isClosable(false),
+          model(nullptr), batching(false), hasOlderPosts(false), addingOlderPosts(false), scrollAnchor(-1),
+          isDirty(false), memoryBytes(0)
     {
         if (account->microblog()->isValidTimeline(timelineName)) {
             info = account->microblog()->timelineInfo(timelineName);
@@ -63,7 +76,7 @@ public:
     bool mStartUp;
     QPointer<QPushButton> btnMarkAllAsRead;
     int unreadCount;
-    QMap<QString, PostWidget *> posts;
+    QHash<QString, PostWidget *> posts;     // Hashed, For constant time lookups of arriving posts
     QMultiMap<QDateTime, PostWidget *>  sortedPostsList;
     QVBoxLayout *mainLayout;
     QHBoxLayout *titleBarLayout;
@@ -74,36 +87,253 @@ public:
     Choqok::TimelineInfo *info;
     bool isClosable;
     QIcon timelineIcon;
+    TimelineModel *model;
+    QTimer visiblePostsTimer;
+    QTimer relayoutTimer;
+    QSet<PostWidget *> uninitialized; // Posts waiting to come near viewport, for PostWidget::initUi()
+    QSet<PostWidget *> realized;      // Posts which are realized, To release them when they go far from viewport
+    bool batching;
+    QList<PostWidget *> batchAdding;  // Posts of current batch, for postWidgetsAdding
+    QList<PostWidget *> batchAdded;   // Initialized posts of current batch, for newPostWidgetsAdded
+    QSet<PostWidget *> pendingContent; // Initialized posts waiting for their content, for newPostWidgetsAdded
+    QList<PostWidget *> prepared;     // Posts which got their content, Reported together on preparedTimer
+    QTimer preparedTimer;
+    bool hasOlderPosts;               // Older pages may be on disk
+    QSet<PostWidget *> pagedIn;       // Posts of older pages, Kept from retention limits while user is near them
+    bool addingOlderPosts;            // Posts are added at the end of oldest ones
+    int scrollAnchor;                 // Distance from bottom to keep on next range change, Or -1
+    bool isDirty;                     // Posts changed since last save
+    QHash<PostWidget *, qint64> postMemory; // Memory usage of each post as last counted
+    qint64 memoryBytes;               // Sum of postMemory
+
+    /**
+    Count memory usage of @p widget again, On changes of it which timeline knows about
+    */
+    void countMemory(PostWidget *widget)
+    {
+        const qint64 bytes = widget->memoryUsage();
+        memoryBytes += bytes - postMemory.value(widget);
+        postMemory.insert(widget, bytes);
+    }
+
+    void uncountMemory(PostWidget *widget)
+    {
+        memoryBytes -= postMemory.take(widget);
+    }
+
+    /**
+    @return First row which ends at or below @p y, Or row count
+    Rows are laid out in order of model, So it's a binary search. A hidden row has no place in layout,
+    The first shown row after it stands for it.
+    */
+    int firstRowEndingBelow(int y) const
+    {
+        int low = 0;
+        int high = model->rowCount();
+        while (low < high) {
+            const int middle = (low + high) / 2;
+            int row = middle;
+            while (row < high && model->postWidget(row)->isHidden()) {
+                ++row;
+            }
+            if (row < high && model->postWidget(row)->geometry().bottom() < y) {
+                low = row + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    /**
+    @return true if @p widget is a read post out of sight, Which retention limits may close
+    */
+    bool isEvictable(PostWidget *widget) const
+    {
+        if (!widget->isRead() || pagedIn.contains(widget)) {
+            return false;
+        }
+        if (!scrollArea->isVisible()) {
+            return true;
+        }
+        const int top = scrollArea->verticalScrollBar()->value();
+        const QRect rect = widget->geometry();
+        return rect.bottom() < top || rect.top() > top + scrollArea->viewport()->height();
+    }
 };
 
+/**
+Posts inside this many viewport heights from the visible area get realized,
+and the ones outside of KeepMargin get released.
+*/
+static const int RealizeMargin = 1;
+static const int KeepMargin = 3;
+
+/**
+Delay of relayout after last resize event, in milliseconds
+*/
+static const int RelayoutDelay = 100;
+
+/**
+Height of a post before its first initialization, roughly one with a single line of text
+*/
+static const int PlaceholderHeight = 64;
+
+/**
+Count of posts loaded from disk at once, When user scrolls to the oldest ones
+*/
+static const int OlderPostsPageSize = 25;
+
+/**
+Open timelines, Global retention limits apply to all of them
+Each timeline registers itself on construction and leaves on destruction.
+*/
+class TimelineRegistry
+{
+public:
+    void add(TimelineWidget *timeline)
+    {
+        timelines.append(timeline);
+    }
+
+    void remove(TimelineWidget *timeline)
+    {
+        timelines.removeOne(timeline);
+    }
+
+    const QList<TimelineWidget *> &all() const
+    {
+        return timelines;
+    }
+
+private:
+    QList<TimelineWidget *> timelines;
+};
+
+Q_GLOBAL_STATIC(TimelineRegistry, _timelines)
+
+static const qint64 MiB = 1024 * 1024;
+
 TimelineWidget::TimelineWidget(Choqok::Account *account, const QString &timelineName, QWidget *parent /*= 0*/)
     : QWidget(parent), d(new Private(account, timelineName))
 {
     setAttribute(Qt::WA_DeleteOnClose);
+    d->model = new TimelineModel(this);
+    d->visiblePostsTimer.setSingleShot(true);
+    d->visiblePostsTimer.setInterval(0);
+    connect(&d->visiblePostsTimer, &QTimer::timeout, this, &TimelineWidget::updateVisiblePosts);
+    d->relayoutTimer.setSingleShot(true);
+    d->relayoutTimer.setInterval(RelayoutDelay);
+    connect(&d->relayoutTimer, &QTimer::timeout, this, &TimelineWidget::relayoutPosts);
+    d->preparedTimer.setSingleShot(true);
+    d->preparedTimer.setInterval(0);
+    connect(&d->preparedTimer, &QTimer::timeout, this, &TimelineWidget::reportPreparedPosts);
+    _timelines->add(this);
     setupUi();
     loadTimeline();
 }
 
 TimelineWidget::~TimelineWidget()
 {
+    if (!_timelines.isDestroyed()) {
+        _timelines->remove(this);
+    }
     delete d;
 }
 
 void TimelineWidget::loadTimeline()
 {
-    QList<Choqok::Post *> list = currentAccount()->microblog()->loadTimeline(currentAccount(), timelineName());
+    // Only the newest page, Older ones are loaded on scroll back. @see loadOlderPosts()
+    QList<Choqok::Post *> list = currentAccount()->microblog()->loadTimeline(currentAccount(), timelineName(),
+                                                                             BehaviorSettings::countOfPosts());
+    d->hasOlderPosts = true;
     connect(currentAccount()->microblog(), &MicroBlog::saveTimelines, this, &TimelineWidget::saveTimeline);
 
     if (!BehaviorSettings::markAllAsReadOnExit()) {
         addNewPosts(list);
     } else {
+        QList<PostWidget *> widgets;
         for (Choqok::Post *p: list) {
             PostWidget *pw = d->currentAccount->microblog()->createPostWidget(d->currentAccount, p, this);
             if (pw) {
                 pw->setRead();
-                addPostWidgetToUi(pw);
+                widgets.append(pw);
             }
         }
+        addPostWidgetsToUi(widgets);
+        removeOldPosts();
+    }
+    // Loaded posts are already on disk
+    d->isDirty = BehaviorSettings::markAllAsReadOnExit();
+    if (currentAccount()->microblog()->isValidTimeline(timelineName())) {
+        SearchIndex::self()->indexTimeline(currentAccount(), timelineName());
+    }
+}
+
+void TimelineWidget::loadOlderPosts()
+{
+    if (!d->hasOlderPosts || d->sortedPostsList.isEmpty()) {
+        return;
+    }
+    // Oldest post is the cursor, Of posts created at the same time the one with smallest id
+    auto it = d->sortedPostsList.constBegin();
+    const Choqok::Post *oldest = it.value()->currentPost();
+    for (; it != d->sortedPostsList.constEnd() && it.key() == oldest->creationDateTime; ++it) {
+        if (it.value()->currentPost()->postId < oldest->postId) {
+            oldest = it.value()->currentPost();
+        }
+    }
+    const QList<Choqok::Post *> list = currentAccount()->microblog()->loadTimeline(currentAccount(), timelineName(),
+                                                                                   OlderPostsPageSize, oldest);
+    if (list.isEmpty()) {
+        d->hasOlderPosts = false;
+    }
+    qCDebug(CHOQOK) << d->currentAccount->alias() << d->timelineName << "Loaded" << list.count() << "older posts";
+
+    int unread = 0;
+    QList<PostWidget *> widgets;
+    // Newest first, Each one goes past the previous one
+    for (int i = list.count() - 1; i >= 0; --i) {
+        Choqok::Post *p = list[i];
+        if (d->posts.contains(p->postId)) {
+            delete p;
+            continue;
+        }
+        PostWidget *pw = d->currentAccount->microblog()->createPostWidget(d->currentAccount, p, this);
+        if (pw) {
+            if (BehaviorSettings::markAllAsReadOnExit()) {
+                pw->setRead();
+            } else if (!pw->isRead()) {
+                ++unread;
+            }
+            widgets.append(pw);
+        }
+    }
+    if (d->order != 0) {
+        // Oldest posts are on top, Keep the visible ones in place
+        const QScrollBar *bar = d->scrollArea->verticalScrollBar();
+        d->scrollAnchor = bar->maximum() - bar->value();
+    }
+    // Posts of older pages are already on disk
+    const bool wasDirty = d->isDirty;
+    d->pagedIn.unite(QSet<PostWidget *>::fromList(widgets));
+    d->addingOlderPosts = true;
+    addPostWidgetsToUi(widgets);
+    d->addingOlderPosts = false;
+    d->isDirty = wasDirty || BehaviorSettings::markAllAsReadOnExit();
+    if (unread) {
+        d->unreadCount += unread;
+        Q_EMIT updateUnreadCount(unread);
+        showMarkAllAsReadButton();
+    }
+}
+
+void TimelineWidget::restoreScrollAnchor(int min, int max)
+{
+    Q_UNUSED(min);
+    if (d->scrollAnchor >= 0) {
+        d->scrollArea->verticalScrollBar()->setValue(max - d->scrollAnchor);
+        d->scrollAnchor = -1;
     }
 }
 
@@ -150,6 +380,8 @@ void TimelineWidget::setupUi()
     QFont fnt = d->lblDesc->font();
     fnt.setBold(true);
     d->lblDesc->setFont(fnt);
+    d->lblDesc->installEventFilter(this);
+    setStyleSheet(PostWidget::postsStyleSheet());
 
     QVBoxLayout *gridLayout;
     QWidget *scrollAreaWidgetContents;
@@ -182,6 +414,12 @@ void TimelineWidget::setupUi()
 
     gridLayout->addLayout(d->titleBarLayout);
     gridLayout->addWidget(d->scrollArea);
+    connect(d->scrollArea->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &TimelineWidget::scheduleVisiblePostsUpdate);
+    connect(d->scrollArea->verticalScrollBar(), &QScrollBar::rangeChanged,
+            this, &TimelineWidget::restoreScrollAnchor);
+    connect(d->scrollArea->verticalScrollBar(), &QScrollBar::rangeChanged,
+            this, &TimelineWidget::scheduleVisiblePostsUpdate);
     if (AppearanceSettings::useReverseOrder()) {
         d->order = -1;
         QTimer::singleShot(0, this, SLOT(scrollToBottom()));
@@ -192,15 +430,102 @@ void TimelineWidget::setupUi()
 
 void TimelineWidget::removeOldPosts()
 {
-    int count = d->sortedPostsList.count() - BehaviorSettings::countOfPosts();
-//     qCDebug(CHOQOK)<<count;
-    while (count > 0 && !d->sortedPostsList.isEmpty()) {
-        PostWidget *wd = d->sortedPostsList.values().first();
-        if (wd && wd->isRead()) {
-            wd->close();
+    const int maxCount = BehaviorSettings::countOfPosts();
+    const qint64 maxBytes = BehaviorSettings::timelineMemoryBudget() * MiB;
+    int count = d->sortedPostsList.count();
+    qint64 bytes = d->memoryBytes;
+
+    // Oldest first, Unread posts are kept until user reads them
+    QList<PostWidget *> evicted;
+    for (auto it = d->sortedPostsList.constBegin();
+            it != d->sortedPostsList.constEnd() && (count > maxCount || bytes > maxBytes); ++it) {
+        PostWidget *wd = it.value();
+        if (d->isEvictable(wd)) {
+            evicted.append(wd);
+            --count;
+            bytes -= d->postMemory.value(wd);
         }
-        --count;
     }
+    evictPosts(evicted);
+    removeOldPostsOfAllTimelines();
+}
+
+void TimelineWidget::removeOldPostsOfAllTimelines()
+{
+    const int maxCount = BehaviorSettings::totalCountOfPosts();
+    const qint64 maxBytes = BehaviorSettings::totalMemoryBudget() * MiB;
+    int count = 0;
+    qint64 bytes = 0;
+    // Running totals of timelines, Posts are not visited unless some are to be removed
+    const QList<TimelineWidget *> &timelines = _timelines->all();
+    for (TimelineWidget *timeline: timelines) {
+        count += timeline->d->sortedPostsList.count();
+        bytes += timeline->d->memoryBytes;
+    }
+    if (count <= maxCount && bytes <= maxBytes) {
+        return;
+    }
+
+    // Oldest posts of all timelines, Merged from their sorted lists as far as needed
+    typedef QPair<TimelineWidget *, QMultiMap<QDateTime, PostWidget *>::const_iterator> Cursor;
+    const auto newer = [](const Cursor &a, const Cursor &b) {
+        return b.second.key() < a.second.key();
+    };
+    QVector<Cursor> heads;
+    for (TimelineWidget *timeline: timelines) {
+        if (!timeline->d->sortedPostsList.isEmpty()) {
+            heads.append(qMakePair(timeline, timeline->d->sortedPostsList.constBegin()));
+        }
+    }
+    std::make_heap(heads.begin(), heads.end(), newer);
+    QHash<TimelineWidget *, QList<PostWidget *> > evicted;
+    while (!heads.isEmpty() && (count > maxCount || bytes > maxBytes)) {
+        std::pop_heap(heads.begin(), heads.end(), newer);
+        Cursor &head = heads.last();
+        PostWidget *wd = head.second.value();
+        if (head.first->d->isEvictable(wd)) {
+            evicted[head.first].append(wd);
+            --count;
+            bytes -= head.first->d->postMemory.value(wd);
+        }
+        if (++head.second == head.first->d->sortedPostsList.constEnd()) {
+            heads.removeLast();
+        } else {
+            std::push_heap(heads.begin(), heads.end(), newer);
+        }
+    }
+    for (auto it = evicted.constBegin(); it != evicted.constEnd(); ++it) {
+        it.key()->evictPosts(it.value());
+    }
+}
+
+void TimelineWidget::evictPosts(const QList<PostWidget *> &widgets)
+{
+    if (widgets.isEmpty()) {
+        return;
+    }
+    qCDebug(CHOQOK) << d->currentAccount->alias() << d->timelineName << "Evicting" << widgets.count() << "posts";
+    // They can be loaded again, From next update of visible posts on
+    d->hasOlderPosts = true;
+    currentAccount()->microblog()->archivePosts(currentAccount(), timelineName(), widgets);
+    for (PostWidget *wd: widgets) {
+        wd->close();
+    }
+}
+
+qint64 TimelineWidget::memoryUsage() const
+{
+    return d->memoryBytes;
+}
+
+bool TimelineWidget::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == d->lblDesc && event->type() == QEvent::ToolTip) {
+        // Computed on demand, to always show current usage
+        d->lblDesc->setToolTip(i18np("1 post, about %2 in memory", "%1 posts, about %2 in memory",
+                                     d->sortedPostsList.count(), KFormat().formatByteSize(memoryUsage())));
+    }
+    return QWidget::eventFilter(watched, event);
 }
 
 void TimelineWidget::addPlaceholderMessage(const QString &msg)
@@ -218,18 +543,32 @@ void TimelineWidget::addNewPosts(QList< Choqok::Post * > &postList)
 {
     qCDebug(CHOQOK) << d->currentAccount->alias() << d->timelineName << postList.count();
     int unread = 0;
+    QList<PostWidget *> widgets;
+    QSet<QString> batchIds;
     for (Choqok::Post *p: postList) {
-        if (d->posts.keys().contains(p->postId)) {
+        if (d->posts.contains(p->postId) || batchIds.contains(p->postId)) {
             continue;
         }
         PostWidget *pw = d->currentAccount->microblog()->createPostWidget(d->currentAccount, p, this);
         if (pw) {
-            addPostWidgetToUi(pw);
+            batchIds.insert(p->postId);
+            widgets.append(pw);
             if (!pw->isRead()) {
                 ++unread;
             }
         }
     }
+    addPostWidgetsToUi(widgets);
+    if (currentAccount()->microblog()->isValidTimeline(timelineName())) {
+        // Only posts which are on timeline now, Not the known or filtered ones
+        QList<Choqok::Post *> inserted;
+        for (PostWidget *widget: widgets) {
+            if (d->posts.value(widget->currentPost()->postId) == widget) {
+                inserted.append(widget->currentPost());
+            }
+        }
+        SearchIndex::self()->addPosts(currentAccount(), timelineName(), inserted);
+    }
     removeOldPosts();
     if (unread) {
         d->unreadCount += unread;
@@ -259,17 +598,50 @@ void TimelineWidget::showMarkAllAsReadButton()
 
 void TimelineWidget::addPostWidgetToUi(PostWidget *widget)
 {
-    widget->initUi();
+    // New unread posts are initialized right away, So plugins (e.g. notifications) get them in time
+    const bool deferred = Application::isStartingUp() || widget->isRead();
+    if (deferred) {
+        widget->setRealized(false);
+        widget->setFixedHeight(PlaceholderHeight);
+        d->uninitialized.insert(widget);
+    } else {
+        widget->initUi();
+        d->realized.insert(widget);
+    }
     widget->setFocusProxy(this);
     widget->setObjectName(widget->currentPost()->postId);
     connect(widget, &PostWidget::resendPost, this, &TimelineWidget::forwardResendPost);
     connect(widget, &PostWidget::reply, this, &TimelineWidget::forwardReply);
     connect(widget, &PostWidget::postReaded, this, &TimelineWidget::slotOnePostReaded);
     connect(widget, &PostWidget::aboutClosing, this, &TimelineWidget::postWidgetClosed);
-    d->mainLayout->insertWidget(d->order, widget);
+    connect(widget, &PostWidget::postChanged, this, &TimelineWidget::setDirty);
+    d->isDirty = true;
+    int index = d->order;
+    int row = d->order;
+    if (d->addingOlderPosts) {
+        // Next to the spacer, Which is the first item of layout
+        index = d->order == 0 ? d->mainLayout->count() - 1 : 1;
+        row = d->order == 0 ? -1 : 0;
+    }
+    d->mainLayout->insertWidget(index, widget);
+    d->model->insertPostWidget(row, widget);
+    scheduleVisiblePostsUpdate();
     d->posts.insert(widget->currentPost()->postId, widget);
     d->sortedPostsList.insert(widget->currentPost()->creationDateTime, widget);
-    Global::SessionManager::self()->emitNewPostWidgetAdded(widget, currentAccount(), timelineName());
+    d->countMemory(widget);
+    if (d->batching) {
+        d->batchAdding.append(widget);
+        if (!deferred) {
+            d->batchAdded.append(widget);
+        }
+    } else {
+        // Filters may close it
+        Global::SessionManager::self()->emitPostWidgetsAdding(QList<PostWidget *>() << widget, currentAccount(),
+                                                              timelineName());
+        if (!deferred && d->posts.value(widget->currentPost()->postId) == widget) {
+            reportInitializedPosts(QList<PostWidget *>() << widget);
+        }
+    }
     if (d->placeholderLabel) {
         d->mainLayout->removeWidget(d->placeholderLabel);
         delete d->placeholderLabel;
@@ -293,6 +665,7 @@ void TimelineWidget::markAllAsRead()
         for (PostWidget *pw: d->sortedPostsList) {
             pw->setRead();
         }
+        d->isDirty = true;
         int unread = -d->unreadCount;
         d->unreadCount = 0;
         Q_EMIT updateUnreadCount(unread);
@@ -313,6 +686,7 @@ Account *TimelineWidget::currentAccount()
 
 void TimelineWidget::settingsChanged()
 {
+    setStyleSheet(PostWidget::postsStyleSheet());
     for (PostWidget *pw: d->sortedPostsList) {
         pw->setUiStyle();
     }
@@ -320,20 +694,32 @@ void TimelineWidget::settingsChanged()
 
 void TimelineWidget::slotOnePostReaded()
 {
+    d->isDirty = true;
     d->unreadCount--;
     Q_EMIT updateUnreadCount(-1);
-    if (d->unreadCount == 0) {
+    if (d->unreadCount == 0 && d->btnMarkAllAsRead) {
         d->btnMarkAllAsRead->deleteLater();
     }
 }
 
 void TimelineWidget::saveTimeline()
 {
+    // Microblogs count saved timelines on shutdown, And changes of posts in place may be missed
+    if (!d->isDirty && !Application::isShuttingDown()) {
+        qCDebug(CHOQOK_PERF) << "Skipped saving unchanged timeline" << d->currentAccount->alias() << d->timelineName;
+        return;
+    }
     if (currentAccount()->microblog()) {
         currentAccount()->microblog()->saveTimeline(currentAccount(), timelineName(), posts().values());
+        d->isDirty = false;
     }
 }
 
+void TimelineWidget::setDirty()
+{
+    d->isDirty = true;
+}
+
 QList< PostWidget * > TimelineWidget::postWidgets()
 {
     return posts().values();
@@ -341,11 +727,206 @@ QList< PostWidget * > TimelineWidget::postWidgets()
 
 void TimelineWidget::postWidgetClosed(const QString &postId, PostWidget *post)
 {
+    d->isDirty = true;
     d->posts.remove(postId);
     d->sortedPostsList.remove(post->currentPost()->creationDateTime, post);
+    d->model->removePostWidget(post);
+    d->uninitialized.remove(post);
+    d->pendingContent.remove(post);
+    d->prepared.removeOne(post);
+    d->pagedIn.remove(post);
+    d->realized.remove(post);
+    d->uncountMemory(post);
+}
+
+void TimelineWidget::reportInitializedPosts(const QList<PostWidget *> &widgets)
+{
+    // Plugins read links and URLs of content, So posts are reported once their content is prepared
+    QList<PostWidget *> ready;
+    for (PostWidget *widget: widgets) {
+        if (widget->isContentPending()) {
+            d->pendingContent.insert(widget);
+            connect(widget, &PostWidget::contentPrepared, this, &TimelineWidget::postContentPrepared,
+                    Qt::UniqueConnection);
+        } else {
+            ready.append(widget);
+        }
+    }
+    Global::SessionManager::self()->emitNewPostWidgetsAdded(ready, currentAccount(), timelineName());
+}
+
+void TimelineWidget::postContentPrepared()
+{
+    PostWidget *widget = qobject_cast<PostWidget *>(sender());
+    if (widget && d->pendingContent.remove(widget)) {
+        d->countMemory(widget);
+        d->prepared.append(widget);
+        d->preparedTimer.start();
+    }
+}
+
+void TimelineWidget::reportPreparedPosts()
+{
+    const QList<PostWidget *> widgets = d->prepared;
+    d->prepared.clear();
+    Global::SessionManager::self()->emitNewPostWidgetsAdded(widgets, currentAccount(), timelineName());
+}
+
+void TimelineWidget::addPostWidgetsToUi(const QList<PostWidget *> &widgets)
+{
+    if (widgets.isEmpty()) {
+        return;
+    }
+    QWidget *contents = d->scrollArea->widget();
+    contents->setUpdatesEnabled(false);
+    d->mainLayout->setEnabled(false);
+    d->batching = true;
+    for (PostWidget *widget: widgets) {
+        addPostWidgetToUi(widget);
+    }
+    d->batching = false;
+    d->mainLayout->setEnabled(true);
+    d->mainLayout->update();
+    contents->setUpdatesEnabled(true);
+
+    // Filters decide on post data first, Initialized posts they closed are not reported
+    Global::SessionManager::self()->emitPostWidgetsAdding(d->batchAdding, currentAccount(), timelineName());
+    d->batchAdding.clear();
+    QList<PostWidget *> added;
+    for (PostWidget *widget: d->batchAdded) {
+        if (d->posts.value(widget->currentPost()->postId) == widget) {
+            added.append(widget);
+        }
+    }
+    d->batchAdded.clear();
+    reportInitializedPosts(added);
+}
+
+bool TimelineWidget::initPostWidget(PostWidget *widget)
+{
+    if (!d->uninitialized.remove(widget)) {
+        return false;
+    }
+    // Widget is still unrealized here, So plugin changes end in one render on setRealized()
+    widget->initUi();
+    d->countMemory(widget);
+    return true;
+}
+
+TimelineModel *TimelineWidget::model() const
+{
+    return d->model;
+}
+
+void TimelineWidget::scheduleVisiblePostsUpdate()
+{
+    d->visiblePostsTimer.start();
+}
+
+void TimelineWidget::schedulePostsRelayout()
+{
+    d->relayoutTimer.start();
+}
+
+void TimelineWidget::relayoutPosts()
+{
+    // Unrealized posts take a height they had at new width, If any, And are measured on realization
+    const int count = d->model->rowCount();
+    for (int row = 0; row < count; ++row) {
+        d->model->postWidget(row)->relayout();
+    }
+    scheduleVisiblePostsUpdate();
+}
+
+void TimelineWidget::updateVisiblePosts()
+{
+    if (!isVisible()) {
+        return;
+    }
+    const int viewportHeight = d->scrollArea->viewport()->height();
+    const int top = d->scrollArea->verticalScrollBar()->value();
+    const int realizeTop = top - RealizeMargin * viewportHeight;
+    const int realizeBottom = top + (RealizeMargin + 1) * viewportHeight;
+    const int keepTop = top - KeepMargin * viewportHeight;
+    const int keepBottom = top + (KeepMargin + 1) * viewportHeight;
+
+    // Only rows near viewport and the ones realized before are visited, Not all of timeline
+    QList<PostWidget *> release;
+    for (PostWidget *widget: d->realized) {
+        const QRect rect = widget->geometry();
+        if (!widget->isHidden() && (rect.bottom() < keepTop || rect.top() > keepBottom)) {
+            release.append(widget);
+        }
+    }
+    for (PostWidget *widget: release) {
+        widget->setRealized(false);
+        d->realized.remove(widget);
+        d->countMemory(widget);
+    }
+    QList<PostWidget *> realize;
+    QList<PostWidget *> initialized;
+    const int count = d->model->rowCount();
+    for (int row = d->firstRowEndingBelow(realizeTop); row < count; ++row) {
+        PostWidget *widget = d->model->postWidget(row);
+        if (widget->isHidden()) {
+            continue;
+        }
+        if (widget->geometry().top() > realizeBottom) {
+            break;
+        }
+        if (initPostWidget(widget)) {
+            initialized.append(widget);
+        }
+        realize.append(widget);
+    }
+    // Plugins get the whole batch before the first render of these posts
+    reportInitializedPosts(initialized);
+    for (PostWidget *widget: realize) {
+        widget->setRealized(true);
+        d->realized.insert(widget);
+        d->countMemory(widget);
+    }
+
+    const QScrollBar *bar = d->scrollArea->verticalScrollBar();
+    const bool nearOldest = d->order == 0 ? bar->maximum() - top <= viewportHeight : top <= viewportHeight;
+    if (d->hasOlderPosts && nearOldest) {
+        loadOlderPosts();
+        return;
+    }
+    // Posts of older pages are subject to retention limits again once they are beyond the kept margin,
+    // Much farther than the distance which loads a page. So evicting them doesn't bring user near oldest.
+    QList<PostWidget *> released;
+    for (PostWidget *widget: d->pagedIn) {
+        const QRect rect = widget->geometry();
+        if (rect.bottom() < keepTop || rect.top() > keepBottom) {
+            released.append(widget);
+        }
+    }
+    if (released.isEmpty()) {
+        return;
+    }
+    for (PostWidget *widget: released) {
+        d->pagedIn.remove(widget);
+    }
+    if (d->order != 0) {
+        d->scrollAnchor = bar->maximum() - bar->value();
+    }
+    removeOldPosts();
+}
+
+void TimelineWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    scheduleVisiblePostsUpdate();
+}
+
+void TimelineWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    scheduleVisiblePostsUpdate();
 }
 
-QMap< QString, PostWidget * > &TimelineWidget::posts() const
+QHash<QString, PostWidget *> &TimelineWidget::posts() const
 {
     return d->posts;
 }
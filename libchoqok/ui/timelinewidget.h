@@ -22,6 +22,7 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #ifndef TIMELINEWIDGET_H
 #define TIMELINEWIDGET_H
 
+#include <QHash>
 #include <QIcon>
 #include <QMap>
 #include <QWidget>
@@ -41,6 +42,7 @@ namespace UI
 {
 
 class PostWidget;
+class TimelineModel;
 /**
 @brief Choqok base Timeline Widget
 
@@ -93,10 +95,19 @@ public:
     int unreadCount() const;
 
     /**
-    @brief remove old posts, about to user selected count of posts on timelines
+    @brief Remove old posts, about to user selected count and memory budget of posts on timelines
+    Only read posts get removed, oldest first, And they are archived by @ref MicroBlog::archivePosts()
+    Global limits of all timelines are applied afterwards.
     */
     void removeOldPosts();
 
+    /**
+    @return Rough estimation of memory used by posts of this timeline, in bytes
+    It's a running total, Posts are counted again when they are added, realized, released or get their content.
+    @see PostWidget::memoryUsage()
+    */
+    qint64 memoryUsage() const;
+
     /**
     @return list of all widgets available on this timeline
     */
@@ -109,6 +120,17 @@ public:
 
     void setClosable(bool isClosable = true);
 
+    /**
+    @return Model of posts on this timeline, in the order they are shown
+    */
+    TimelineModel *model() const;
+
+    /**
+    Schedule one deferred @ref PostWidget::relayout() of posts
+    PostWidgets call this on width change, to coalesce resize events of the timeline.
+    */
+    void schedulePostsRelayout();
+
 public Q_SLOTS:
     /**
     @brief Mark all posts as read
@@ -138,16 +160,60 @@ protected Q_SLOTS:
     void slotOnePostReaded();
     virtual void saveTimeline();
     virtual void loadTimeline();
+
+    /**
+    @brief Load the page of posts before the oldest one on this timeline from disk
+    Called when user scrolls near the oldest posts, Loaded posts are kept until user is back to the newest ones.
+    @see MicroBlog::loadTimeline()
+    */
+    void loadOlderPosts();
     void postWidgetClosed(const QString &postId, PostWidget *widget);
 
+    /**
+    @brief Realize the posts near to viewport, and release the far ones
+    @see PostWidget::setRealized()
+    */
+    void updateVisiblePosts();
+
+    /**
+    @brief Call @ref PostWidget::relayout() of posts
+    */
+    void relayoutPosts();
+
+    void restoreScrollAnchor(int min, int max);
+
+    /**
+    Report posts waiting for their content with @ref Global::SessionManager::newPostWidgetsAdded()
+    @see PostWidget::contentPrepared()
+    */
+    void postContentPrepared();
+    void reportPreparedPosts();
+
+    /**
+    Mark this timeline as changed, So it's saved on next @ref saveTimeline()
+    */
+    void setDirty();
+
 protected:
     /**
     Add a PostWidget to UI
-    @Note This will call @ref PostWidget::initUi()
+    @Note This will call @ref PostWidget::initUi() and @ref Global::SessionManager::newPostWidgetsAdded()
+    when the widget comes near the viewport for the first time, Until then it's a placeholder.
+    New unread posts are initialized right away. @ref Global::SessionManager::postWidgetsAdding() is
+    emitted for all posts when they are added.
     */
     virtual void addPostWidgetToUi(PostWidget *widget);
+
+    /**
+    Add a batch of PostWidgets to UI with @ref addPostWidgetToUi()
+    Layout of timeline is suspended during the batch, and posts are reported with a single
+    @ref Global::SessionManager::postWidgetsAdding(), Then initialized ones which are still open with a single
+    @ref Global::SessionManager::newPostWidgetsAdded(). Posts with content pending on worker thread are
+    reported when it's prepared.
+    */
+    void addPostWidgetsToUi(const QList<PostWidget *> &widgets);
     Account *currentAccount();
-    QMap<QString, PostWidget *> &posts() const;
+    QHash<QString, PostWidget *> &posts() const;
     QMultiMap<QDateTime, PostWidget *> &sortedPostsList() const;
 
     QVBoxLayout *mainLayout();
@@ -155,9 +221,34 @@ protected:
     QLabel *timelineDescription();
     virtual void setUnreadCount(int unread);
     virtual void showMarkAllAsReadButton();
+    virtual void resizeEvent(QResizeEvent *event) override;
+    virtual void showEvent(QShowEvent *event) override;
+    virtual bool eventFilter(QObject *watched, QEvent *event) override;
+
+    /**
+    Archive and close @p widgets
+    */
+    void evictPosts(const QList<PostWidget *> &widgets);
+
+    /**
+    Schedule a call to @ref updateVisiblePosts() on next event loop iteration
+    */
+    void scheduleVisiblePostsUpdate();
+
+    /**
+    Call @ref PostWidget::initUi() of @p widget if it's not initialized yet
+    @return true if @p widget is initialized now
+    */
+    bool initPostWidget(PostWidget *widget);
 
 private:
     void setupUi();
+    /**
+    Emit @ref Global::SessionManager::newPostWidgetsAdded() for initialized @p widgets, Each one once its
+    content is prepared. @see PostWidget::isContentPending()
+    */
+    void reportInitializedPosts(const QList<PostWidget *> &widgets);
+    static void removeOldPostsOfAllTimelines();
     class Private;
     Private *const d;
 };
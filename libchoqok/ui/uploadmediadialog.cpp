@@ -94,6 +94,8 @@ UploadMediaDialog::UploadMediaDialog(QWidget *parent, const QString &url)
             this, &UploadMediaDialog::slotMediumUploaded);
     connect(Choqok::MediaManager::self(), &MediaManager::mediumUploadFailed,
             this, &UploadMediaDialog::slotMediumUploadFailed);
+    connect(Choqok::MediaManager::self(), &MediaManager::mediumUploadProgress,
+            this, &UploadMediaDialog::slotMediumUploadProgress);
 }
 
 UploadMediaDialog::~UploadMediaDialog()
@@ -272,6 +274,15 @@ void Choqok::UI::UploadMediaDialog::slotMediumUploadFailed(const QUrl &localUrl,
     resize(winSize);
 }
 
+void Choqok::UI::UploadMediaDialog::slotMediumUploadProgress(const QUrl &localUrl, int percent)
+{
+    if (d->localUrl == localUrl && d->progress) {
+        d->progress->setRange(0, 100);
+        d->progress->setValue(percent);
+        d->progress->setFormat(i18n("Uploading... %p%"));
+    }
+}
+
 void Choqok::UI::UploadMediaDialog::slotMediumChanged(const QString &url)
 {
     d->ui.previewer->showPreview(QUrl::fromLocalFile(url));
@@ -53,6 +53,7 @@ protected Q_SLOTS:
     void slotConfigureClicked();
     void slotMediumUploadFailed(const QUrl &localUrl, const QString &errorMessage);
     void slotMediumUploaded(const QUrl &localUrl, const QString &remoteUrl);
+    void slotMediumUploadProgress(const QUrl &localUrl, int percent);
     void slotMediumChanged(const QString &url);
 
 private:
@@ -23,6 +23,8 @@
 
 #include "uploader.h"
 
+#include <KJob>
+
 namespace Choqok
 {
 
@@ -35,5 +37,12 @@ Choqok::Uploader::Uploader(const QString &componentName, QObject *parent)
 Choqok::Uploader::~Uploader()
 {}
 
+void Choqok::Uploader::watchProgress(KJob *job, const QUrl &localUrl)
+{
+    connect(job, &KJob::percent, this, [this, localUrl](KJob *, unsigned long percent) {
+        Q_EMIT uploadingProgress(localUrl, int(percent));
+    });
+}
+
 }
 
@@ -28,6 +28,8 @@
 
 #include "plugin.h"
 
+class KJob;
+
 namespace Choqok
 {
 
@@ -44,14 +46,24 @@ public:
 
     /*virtual void upload( const QString &localUrl, const QByteArray &mediumType,
                             const QString &optionalMessage = QString() );*/
+    /**
+    Upload @p medium read from @p localUrl
+    @p medium may refer to a memory mapped file, So it must not be kept after this call returns.
+    */
     virtual void upload(const QUrl &localUrl, const QByteArray &medium, const QByteArray &mediumType) = 0;
 
 Q_SIGNALS:
     void mediumUploaded(const QUrl &localUrl, const QString &remoteUrl);
     void uploadingFailed(const QUrl &localUrl, const QString &errorMessage);
+    void uploadingProgress(const QUrl &localUrl, int percent);
 
 protected:
     Uploader(const QString &componentName, QObject *parent);
+
+    /**
+    Report progress of upload @p job of @p localUrl with uploadingProgress()
+    */
+    void watchProgress(KJob *job, const QUrl &localUrl);
 };
 
 }
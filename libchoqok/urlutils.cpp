@@ -22,78 +22,501 @@ along with this program; if not, see http://www.gnu.org/licenses/
 */
 #include "urlutils.h"
 
-#include <QRegExp>
-
-const QString protocols = QLatin1String("((https?|ftps?)://)");
-const QString subdomains = QLatin1String("(([a-z0-9\\-_]{1,}\\.)?)");
-const QString auth = QLatin1String("(([a-z0-9\\-_]{1,})((:[\\S]{1,})?)@)");
-const QString domains = QLatin1String("(([a-z0-9\\-\\x0080-\\xFFFF_]){1,63}\\.)+");
-const QString port = QLatin1String("(:(6553[0-5]|655[0-2][0-9]|65[0-4][\\d]{2}|6[0-4][\\d]{3}|[1-5][\\d]{4}|[1-9][\\d]{0,3}))");
-const QString zone = QLatin1String("((a[cdefgilmnoqrstuwxz])|(b[abdefghijlmnorstvwyz])|(c[acdfghiklmnoruvxyz])|(d[ejkmoz])|(e[ceghrstu])|\
-(f[ijkmor])|(g[abdefghilmnpqrstuwy])|(h[kmnrtu])|(i[delmnoqrst])|(j[emop])|(k[eghimnprwyz])|(l[abcikrstuvy])|\
-(m[acdefghklmnopqrstuvwxyz])|(n[acefgilopruz])|(om)|(p[aefghklnrstwy])|(qa)|(r[eosuw])|(s[abcdeghijklmnortuvyz])|\
-(t[cdfghjkmnoprtvwz])|(u[agksyz])|(v[aceginu])|(w[fs])|(ye)|(z[amrw])\
-|(asia|com|info|net|org|biz|name|pro|aero|cat|coop|edu|jobs|mobi|museum|tel|travel|gov|int|mil|local|xxx)|(中国)|(公司)|(网络)|(صر)|(امارات)|(рф))");
-const QString ip = QLatin1String("(25[0-5]|[2][0-4][0-9]|[0-1]?[\\d]{1,2})(\\.(25[0-5]|[2][0-4][0-9]|[0-1]?[\\d]{1,2})){3}");
-const QString params = QLatin1String("(((\\/)[\\w:/\\?#\\[\\]@!\\$&\\(\\)\\*%\\+,;=\\._~\\x0080-\\xFFFF\\-\\|]{1,}|%[0-9a-f]{2})?)");
-const QString excludingCharacters = QStringLiteral("[^\\s`!()\\[\\]{};:'\".,<>?%1%2%3%4%5%6]")
-                                    .arg(QChar(0x00AB)).arg(QChar(0x00BB)).arg(QChar(0x201C)).arg(QChar(0x201D)).arg(QChar(0x2018)).arg(QChar(0x2019));
-
-const QRegExp UrlUtils::mUrlRegExp(QLatin1String("(((((") + protocols + auth + QLatin1String("?)?)") +
-                                   subdomains +
-                                   QLatin1Char('(') + domains +
-                                   zone + QLatin1String("(?!(\\w))))|(") + protocols + QLatin1Char('(') + ip + QLatin1String(")+))") +
-                                   QLatin1Char('(') + port + QLatin1String("?)") + QLatin1String("((\\/)?)")  +
-                                   params + QLatin1Char(')') + excludingCharacters, Qt::CaseInsensitive);
-
-const QRegExp UrlUtils::mEmailRegExp(QLatin1Char('^') + auth + subdomains + domains + zone);
-const QString hrefTemplate = QLatin1String("<a href='%1' title='%1'>%2</a>");
+#include <QHash>
+#include <QVarLengthArray>
+#include <QVector>
 
-UrlUtils::UrlUtils()
+/**
+The scanner below follows the grammar of the regular expression it replaced, with its
+leftmost-longest matching:
+
+URL:    ((protocol auth?)? subdomain? (label.)+ tld (?!\w) | protocol ip+) port? /? params? last
+E-mail: auth subdomain? (label.)+ tld
+
+Where "last" is a single character which isn't a space or one of the excluded punctuation marks,
+so "example.com/" is a URL but "example.com." is not.
+
+Each position of text is tried once. A try looks ahead over the host, port and path which may start
+there, and a failed host lookahead is remembered so the positions it covered skip host matching.
+Texts made of long dotted runs can still be read more than once, But nothing backtracks like the
+regular expression did.
+*/
+
+namespace
 {
+
+typedef QVarLengthArray<int, 8> Ends;
+
+inline bool isAsciiAlnum(QChar c)
+{
+    const ushort u = c.unicode();
+    return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || (u >= '0' && u <= '9');
 }
 
-UrlUtils::~UrlUtils()
+inline bool isAsciiDigit(QChar c)
 {
+    return c.unicode() >= '0' && c.unicode() <= '9';
 }
 
-QStringList UrlUtils::detectUrls(const QString &text)
+inline bool isWordChar(QChar c)
+{
+    return c.isLetterOrNumber() || c.isMark() || c == QLatin1Char('_');
+}
+
+inline bool isInLatin1Set(QChar c, const char *set)
 {
-    QStringList detectedUrls;
+    const ushort u = c.unicode();
+    return u != 0 && u < 0x80 && qstrchr(set, char(u));
+}
 
-    int pos = 0;
-    while (((pos = mUrlRegExp.indexIn(text, pos)) != -1)) {
-        const QString link = mUrlRegExp.cap(0);
-        if ((pos - 1 > -1 && (text.at(pos - 1) != QLatin1Char('@') &&
-                              text.at(pos - 1) != QLatin1Char('#') && text.at(pos - 1) != QLatin1Char('!'))) ||
-                (pos == 0)) {
-            detectedUrls << link;
+/**
+E-mail addresses are matched case sensitively, Only lower case letters are part of them
+*/
+inline bool isSubdomainChar(QChar c, Qt::CaseSensitivity cs = Qt::CaseInsensitive)
+{
+    if (cs == Qt::CaseSensitive && c.unicode() >= 'A' && c.unicode() <= 'Z') {
+        return false;
+    }
+    return isAsciiAlnum(c) || c == QLatin1Char('-') || c == QLatin1Char('_');
+}
+
+inline bool isDomainChar(QChar c, Qt::CaseSensitivity cs = Qt::CaseInsensitive)
+{
+    return isSubdomainChar(c, cs) || c.unicode() >= 0x80;
+}
+
+inline bool isParamChar(QChar c)
+{
+    return isWordChar(c) || c.unicode() >= 0x80 || isInLatin1Set(c, ":/?#[]@!$&()*%+,;=._~-|");
+}
+
+inline bool isExcluded(QChar c)
+{
+    const ushort u = c.unicode();
+    return c.isSpace() || isInLatin1Set(c, "`!()[]{};:'\".,<>?") ||
+           u == 0x00AB || u == 0x00BB || u == 0x201C || u == 0x201D || u == 0x2018 || u == 0x2019;
+}
+
+inline bool isSigil(QChar c)
+{
+    return c == QLatin1Char('@') || c == QLatin1Char('#') || c == QLatin1Char('!');
+}
+
+inline bool isHexDigit(QChar c)
+{
+    return isAsciiDigit(c) || (c.toLower().unicode() >= 'a' && c.toLower().unicode() <= 'f');
+}
+
+/**
+Case insensitive trie of top level domains
+*/
+class TldTrie
+{
+public:
+    TldTrie()
+    {
+        nodes.append(Node());
+        // Country codes, first letter and its possible second letters
+        static const char *const countries[][2] = {
+            {"a", "cdefgilmnoqrstuwxz"}, {"b", "abdefghijlmnorstvwyz"}, {"c", "acdfghiklmnoruvxyz"},
+            {"d", "ejkmoz"}, {"e", "ceghrstu"}, {"f", "ijkmor"}, {"g", "abdefghilmnpqrstuwy"},
+            {"h", "kmnrtu"}, {"i", "delmnoqrst"}, {"j", "emop"}, {"k", "eghimnprwyz"},
+            {"l", "abcikrstuvy"}, {"m", "acdefghklmnopqrstuvwxyz"}, {"n", "acefgilopruz"}, {"o", "m"},
+            {"p", "aefghklnrstwy"}, {"q", "a"}, {"r", "eosuw"}, {"s", "abcdeghijklmnortuvyz"},
+            {"t", "cdfghjkmnoprtvwz"}, {"u", "agksyz"}, {"v", "aceginu"}, {"w", "fs"}, {"y", "e"}, {"z", "amrw"}
+        };
+        for (const auto &country: countries) {
+            for (const char *second = country[1]; *second; ++second) {
+                add(QLatin1String(country[0]) + QLatin1Char(*second));
+            }
+        }
+        static const char *const generics[] = {
+            "asia", "com", "info", "net", "org", "biz", "name", "pro", "aero", "cat", "coop", "edu", "jobs",
+            "mobi", "museum", "tel", "travel", "gov", "int", "mil", "local", "xxx"
+        };
+        for (const char *generic: generics) {
+            add(QLatin1String(generic));
+        }
+        add(QStringLiteral("中国"));
+        add(QStringLiteral("公司"));
+        add(QStringLiteral("网络"));
+        add(QStringLiteral("صر"));
+        add(QStringLiteral("امارات"));
+        add(QStringLiteral("рф"));
+    }
+
+    /**
+    Append end of every domain of trie which @p text has at @p pos to @p ends
+    */
+    void match(const QString &text, int pos, Qt::CaseSensitivity cs, Ends *ends) const
+    {
+        int node = 0;
+        for (int i = pos; i < text.length(); ++i) {
+            const QChar c = cs == Qt::CaseInsensitive ? text.at(i).toLower() : text.at(i);
+            node = nodes.at(node).children.value(c, -1);
+            if (node == -1) {
+                return;
+            }
+            if (nodes.at(node).terminal) {
+                ends->append(i + 1);
+            }
         }
-        pos += link.length();
     }
 
-    return detectedUrls;
+private:
+    void add(const QString &tld)
+    {
+        int node = 0;
+        for (const QChar c: tld) {
+            int child = nodes.at(node).children.value(c, -1);
+            if (child == -1) {
+                child = nodes.count();
+                nodes[node].children.insert(c, child);
+                nodes.append(Node());
+            }
+            node = child;
+        }
+        nodes[node].terminal = true;
+    }
+
+    struct Node {
+        Node() : terminal(false) {}
+        QHash<QChar, int> children;
+        bool terminal;
+    };
+    QVector<Node> nodes;
+};
+
+Q_GLOBAL_STATIC(TldTrie, tldTrie)
+
+/**
+@return end of "http://", "https://", "ftp://" or "ftps://" at @p pos, or -1
+*/
+int matchProtocol(const QString &text, int pos)
+{
+    int i = pos;
+    if (text.midRef(i, 4).compare(QLatin1String("http"), Qt::CaseInsensitive) == 0) {
+        i += 4;
+    } else if (text.midRef(i, 3).compare(QLatin1String("ftp"), Qt::CaseInsensitive) == 0) {
+        i += 3;
+    } else {
+        return -1;
+    }
+    if (i < text.length() && text.at(i).toLower() == QLatin1Char('s')) {
+        ++i;
+    }
+    return text.midRef(i, 3) == QLatin1String("://") ? i + 3 : -1;
 }
 
-QString UrlUtils::detectEmails(const QString &text)
+/**
+Append the positions after every "user@" or "user:password@" at @p pos to @p ends
+*/
+void matchAuth(const QString &text, int pos, Qt::CaseSensitivity cs, Ends *ends)
 {
-    QString mailtoText(text);
+    int i = pos;
+    while (i < text.length() && isSubdomainChar(text.at(i), cs)) {
+        ++i;
+    }
+    if (i == pos || i >= text.length()) {
+        return;
+    }
+    if (text.at(i) == QLatin1Char('@')) {
+        ends->append(i + 1);
+    } else if (text.at(i) == QLatin1Char(':')) {
+        for (int j = i + 2; j < text.length() && !text.at(j).isSpace(); ++j) {
+            if (text.at(j) == QLatin1Char('@')) {
+                ends->append(j + 1);
+            }
+        }
+    }
+}
+
+/**
+Append ends of hosts "(label.)+tld" starting at @p pos to @p ends
+If @p boundary is true the tld must not be followed by a word character.
 
+@param runEnd set to the end of labels, Hosts starting after @p pos and before it are a subset of these
+@param longLabel set to true if a label longer than 63 characters stopped the scan
+*/
+void matchHosts(const QString &text, int pos, bool boundary, Qt::CaseSensitivity cs, Ends *ends, int *runEnd,
+                bool *longLabel)
+{
+    const int length = text.length();
+    int firstLabelLength = 0;
+    bool firstLabelIsAscii = true;
+    int labels = 0;
+    int i = pos;
+    *longLabel = false;
+    while (true) {
+        int j = i;
+        bool ascii = true;
+        while (j < length && isDomainChar(text.at(j), cs)) {
+            ascii = ascii && isSubdomainChar(text.at(j), cs);
+            ++j;
+        }
+        if (j == i || j >= length || text.at(j) != QLatin1Char('.')) {
+            *runEnd = j;
+            return;
+        }
+        ++labels;
+        if (labels == 1) {
+            firstLabelLength = j - i;
+            firstLabelIsAscii = ascii;
+        } else if (j - i > 63) {
+            *longLabel = true;
+            *runEnd = j;
+            return;
+        }
+        // A first label longer than 63 is only valid as an ascii subdomain of others
+        if (firstLabelLength <= 63 || (labels > 1 && firstLabelIsAscii)) {
+            Ends zones;
+            tldTrie()->match(text, j + 1, cs, &zones);
+            for (int end: zones) {
+                if (!boundary || end >= length || !isWordChar(text.at(end))) {
+                    ends->append(end);
+                }
+            }
+        } else if (!firstLabelIsAscii) {
+            *longLabel = true;
+        }
+        i = j + 1;
+    }
+}
+
+/**
+Append ends of every IP octet (0 to 255) at @p pos to @p ends
+*/
+void matchOctet(const QString &text, int pos, Ends *ends)
+{
+    const int length = text.length();
+    if (pos >= length || !isAsciiDigit(text.at(pos))) {
+        return;
+    }
+    if (pos + 2 < length && isAsciiDigit(text.at(pos + 1)) && isAsciiDigit(text.at(pos + 2))) {
+        const QChar first = text.at(pos);
+        const QChar second = text.at(pos + 1);
+        const QChar third = text.at(pos + 2);
+        if ((first == QLatin1Char('2') && second == QLatin1Char('5') && third >= QLatin1Char('0') && third <= QLatin1Char('5')) ||
+                (first == QLatin1Char('2') && second >= QLatin1Char('0') && second <= QLatin1Char('4') && isAsciiDigit(third)) ||
+                first == QLatin1Char('0') || first == QLatin1Char('1')) {
+            ends->append(pos + 3);
+        }
+    }
+    if (pos + 1 < length && isAsciiDigit(text.at(pos + 1))) {
+        ends->append(pos + 2);
+    }
+    ends->append(pos + 1);
+}
+
+/**
+Append ends of one or more concatenated IPv4 addresses at @p pos to @p ends
+*/
+void matchIps(const QString &text, int pos, Ends *ends)
+{
+    QVarLengthArray<int, 16> starts;
+    starts.append(pos);
+    // Concatenated addresses end within a few characters of each other, So this stays short
+    Ends visited;
+    while (!starts.isEmpty()) {
+        const int start = starts.last();
+        starts.removeLast();
+        Ends current;
+        current.append(start);
+        for (int octet = 0; octet < 4 && !current.isEmpty(); ++octet) {
+            Ends next;
+            for (int i: current) {
+                if (octet > 0) {
+                    if (i >= text.length() || text.at(i) != QLatin1Char('.')) {
+                        continue;
+                    }
+                    ++i;
+                }
+                matchOctet(text, i, &next);
+            }
+            current = next;
+        }
+        for (int end: current) {
+            if (!visited.contains(end)) {
+                visited.append(end);
+                ends->append(end);
+                starts.append(end);
+            }
+        }
+    }
+}
+
+/**
+@return the longest end of "port? /? params? last" after a host ending at @p pos, or -1
+*/
+int matchTail(const QString &text, int pos)
+{
+    const int length = text.length();
+    Ends portEnds;
+    portEnds.append(pos);
+    if (pos < length && text.at(pos) == QLatin1Char(':')) {
+        // 1 to 65535, without leading zeros
+        int value = 0;
+        for (int i = pos + 1; i < length && i <= pos + 5 && isAsciiDigit(text.at(i)); ++i) {
+            if (i == pos + 1 && text.at(i) == QLatin1Char('0')) {
+                break;
+            }
+            value = value * 10 + text.at(i).digitValue();
+            if (value > 65535) {
+                break;
+            }
+            portEnds.append(i + 1);
+        }
+    }
+
+    int best = -1;
+    for (int portEnd: portEnds) {
+        Ends slashEnds;
+        slashEnds.append(portEnd);
+        if (portEnd < length && text.at(portEnd) == QLatin1Char('/')) {
+            slashEnds.append(portEnd + 1);
+        }
+        for (int r: slashEnds) {
+            Ends paramEnds;
+            paramEnds.append(r);
+            if (r + 2 < length && text.at(r) == QLatin1Char('%') && isHexDigit(text.at(r + 1)) && isHexDigit(text.at(r + 2))) {
+                paramEnds.append(r + 3);
+            }
+            if (r < length && text.at(r) == QLatin1Char('/')) {
+                int runEnd = r + 1;
+                while (runEnd < length && isParamChar(text.at(runEnd))) {
+                    ++runEnd;
+                }
+                // Any end inside the run is valid, the last character decides
+                for (int e = runEnd; e >= r + 2; --e) {
+                    if (e < length && !isExcluded(text.at(e))) {
+                        paramEnds.append(e);
+                        break;
+                    }
+                }
+            }
+            for (int e: paramEnds) {
+                if (e < length && !isExcluded(text.at(e))) {
+                    best = qMax(best, e + 1);
+                }
+            }
+        }
+    }
+    return best;
+}
+
+/**
+@return end of the longest URL starting at @p pos or -1
+@param hostRunEnd set to the end of labels when a URL without protocol fails at @p pos,
+Starts before it can't be a URL without protocol either. It's -1 otherwise.
+*/
+int matchUrl(const QString &text, int pos, bool tryHost, int *hostRunEnd)
+{
+    int best = -1;
+    int runEnd;
+    bool longLabel;
+    *hostRunEnd = -1;
+
+    const int afterProtocol = matchProtocol(text, pos);
+    if (afterProtocol != -1) {
+        Ends hostStarts;
+        hostStarts.append(afterProtocol);
+        matchAuth(text, afterProtocol, Qt::CaseInsensitive, &hostStarts);
+        Ends hostEnds;
+        for (int hostStart: hostStarts) {
+            matchHosts(text, hostStart, true, Qt::CaseInsensitive, &hostEnds, &runEnd, &longLabel);
+        }
+        matchIps(text, afterProtocol, &hostEnds);
+        for (int hostEnd: hostEnds) {
+            best = qMax(best, matchTail(text, hostEnd));
+        }
+    }
+
+    if (tryHost && isDomainChar(text.at(pos))) {
+        Ends hostEnds;
+        matchHosts(text, pos, true, Qt::CaseInsensitive, &hostEnds, &runEnd, &longLabel);
+        int hostBest = -1;
+        for (int hostEnd: hostEnds) {
+            hostBest = qMax(hostBest, matchTail(text, hostEnd));
+        }
+        if (hostBest == -1 && !longLabel) {
+            *hostRunEnd = runEnd;
+        }
+        best = qMax(best, hostBest);
+    }
+    return best;
+}
+
+/**
+@return end of the longest e-mail address at @p pos or -1
+*/
+int matchEmail(const QString &text, int pos)
+{
+    Ends hostStarts;
+    matchAuth(text, pos, Qt::CaseSensitive, &hostStarts);
+    int best = -1;
+    int runEnd;
+    bool longLabel;
+    for (int hostStart: hostStarts) {
+        Ends hostEnds;
+        matchHosts(text, hostStart, false, Qt::CaseSensitive, &hostEnds, &runEnd, &longLabel);
+        for (int hostEnd: hostEnds) {
+            best = qMax(best, hostEnd);
+        }
+    }
+    return best;
+}
+
+/**
+@return URLs of @p text, URLs which are preceded by @, # or ! are skipped
+*/
+QStringList scan(const QString &text)
+{
+    QStringList urls;
+    const int length = text.length();
+    int noHostBefore = -1;
     int pos = 0;
-    while (((pos = mEmailRegExp.indexIn(mailtoText, pos)) != -1)) {
-        QString link = mEmailRegExp.cap(0);
-        QString tmplink = link;
-        if ((pos - 1 > -1 && (mailtoText.at(pos - 1) != QLatin1Char('@') &&
-                              mailtoText.at(pos - 1) != QLatin1Char('#') && mailtoText.at(pos - 1) != QLatin1Char('!'))) ||
-                pos == 0) {
-            tmplink.prepend(QLatin1String("mailto:"));
-            mailtoText.remove(pos, link.length());
-            tmplink = hrefTemplate.arg(tmplink, link);
-            mailtoText.insert(pos, tmplink);
+    while (pos < length) {
+        int hostRunEnd = -1;
+        const int urlEnd = matchUrl(text, pos, pos >= noHostBefore, &hostRunEnd);
+        if (hostRunEnd != -1) {
+            noHostBefore = hostRunEnd;
+        }
+        if (urlEnd == -1) {
+            ++pos;
+            continue;
         }
-        pos += tmplink.length();
+        if (pos == 0 || !isSigil(text.at(pos - 1))) {
+            urls << text.mid(pos, urlEnd - pos);
+        }
+        pos = urlEnd;
     }
+    return urls;
+}
 
-    return mailtoText;
 }
 
+const QString hrefTemplate = QLatin1String("<a href='%1' title='%1'>%2</a>");
+
+UrlUtils::UrlUtils()
+{
+}
+
+UrlUtils::~UrlUtils()
+{
+}
+
+QStringList UrlUtils::detectUrls(const QString &text)
+{
+    return scan(text);
+}
+
+QString UrlUtils::detectEmails(const QString &text)
+{
+    // Only an address at the beginning of text is linked, as it always did
+    const int end = text.isEmpty() ? -1 : matchEmail(text, 0);
+    if (end == -1) {
+        return text;
+    }
+    const QString link = text.left(end);
+    return hrefTemplate.arg(QLatin1String("mailto:") + link, link) + text.mid(end);
+}
@@ -36,12 +36,11 @@ public:
     UrlUtils();
     ~UrlUtils();
 
+    /**
+    @Note These are thread safe
+    */
     static QStringList detectUrls(const QString &text);
     static QString detectEmails(const QString &text);
-
-private:
-    static const QRegExp mUrlRegExp;
-    static const QRegExp mEmailRegExp;
 };
 
 #endif // URLUTILS_H
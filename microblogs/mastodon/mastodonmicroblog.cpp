@@ -37,6 +37,7 @@
 #include "application.h"
 #include "choqokappearancesettings.h"
 #include "choqokbehaviorsettings.h"
+#include "choqoktools.h"
 #include "notifymanager.h"
 #include "postwidget.h"
 
@@ -193,6 +194,7 @@ Choqok::Post *MastodonMicroBlog::readPost(const QVariantMap &var, Choqok::Post *
         QTextDocument content;
         content.setHtml(status[QLatin1String("spoiler_text")].toString() + QLatin1String("<br />") + status[QLatin1String("content")].toString());
         p->content += content.toPlainText().trimmed();
+        p->direction = Choqok::textDirection(p->content);
 
         p->creationDateTime = QDateTime::fromString(var[QLatin1String("created_at")].toString(),
                               Qt::ISODate);
@@ -462,8 +464,8 @@ void MastodonMicroBlog::removePost(Choqok::Account *theAccount, Choqok::Post *po
     }
 }
 
-QList<Choqok::Post * > MastodonMicroBlog::loadTimeline(Choqok::Account *account,
-                                                const QString &timelineName)
+QList<Choqok::Post * > MastodonMicroBlog::loadTimelineBackup(Choqok::Account *account,
+                                                      const QString &timelineName)
 {
     QList< Choqok::Post * > list;
     const QString fileName = Choqok::AccountManager::generatePostBackupFileName(account->alias(),
@@ -476,15 +478,10 @@ QList<Choqok::Post * > MastodonMicroBlog::loadTimeline(Choqok::Account *account,
         return list;
     }
 
-    QList<QDateTime> groupList;
-    for (const QString &str: tmpList) {
-        groupList.append(QDateTime::fromString(str));
-    }
-    std::sort(groupList.begin(), groupList.end());
     MastodonPost *st;
-    for (const QDateTime &datetime: groupList) {
+    for (const QString &group: tmpList) {
         st = new MastodonPost;
-        KConfigGroup grp(&postsBackup, datetime.toString());
+        KConfigGroup grp(&postsBackup, group);
         st->creationDateTime = grp.readEntry("creationDateTime", QDateTime::currentDateTime());
         st->postId = grp.readEntry("postId", QString());
         st->link = grp.readEntry("link", QUrl());
@@ -510,10 +507,16 @@ QList<Choqok::Post * > MastodonMicroBlog::loadTimeline(Choqok::Account *account,
         list.append(st);
     }
 
-    if (!list.isEmpty()) {
+    return list;
+}
+
+QList<Choqok::Post *> MastodonMicroBlog::loadTimeline(Choqok::Account *account, const QString &timelineName,
+        int count, const Choqok::Post *before)
+{
+    const QList<Choqok::Post *> list = Choqok::MicroBlog::loadTimeline(account, timelineName, count, before);
+    if (!before && !list.isEmpty()) {
         setLastTimelineId(account, timelineName, list.last()->conversationId);
     }
-
     return list;
 }
 
@@ -576,41 +579,7 @@ QString MastodonMicroBlog::userNameFromAcct(const QString &acct)
 void MastodonMicroBlog::saveTimeline(Choqok::Account *account, const QString &timelineName,
                                      const QList< Choqok::UI::PostWidget * > &timeline)
 {
-    const QString fileName = Choqok::AccountManager::generatePostBackupFileName(account->alias(),
-                             timelineName);
-    KConfig postsBackup(fileName, KConfig::NoGlobals, QStandardPaths::DataLocation);
-
-    ///Clear previous data:
-    for (const QString &group: postsBackup.groupList()) {
-        postsBackup.deleteGroup(group);
-    }
-
-    for (Choqok::UI::PostWidget *wd: timeline) {
-        MastodonPost *post = dynamic_cast<MastodonPost * >(wd->currentPost());
-        KConfigGroup grp(&postsBackup, post->creationDateTime.toString());
-        grp.writeEntry("creationDateTime", post->creationDateTime);
-        grp.writeEntry("postId", post->postId);
-        grp.writeEntry("link", post->link);
-        grp.writeEntry("content", post->content);
-        grp.writeEntry("source", post->source);
-        grp.writeEntry("favorited", post->isFavorited);
-        grp.writeEntry("authorId", post->author.userId);
-        grp.writeEntry("authorRealName", post->author.realName);
-        grp.writeEntry("authorUserName", post->author.userName);
-        grp.writeEntry("authorDescription", post->author.description);
-        grp.writeEntry("authorProfileImageUrl", post->author.profileImageUrl);
-        grp.writeEntry("authorHomePageUrl", post->author.homePageUrl);
-        grp.writeEntry("isRead", post->isRead);
-        grp.writeEntry("conversationId", post->conversationId);
-        grp.writeEntry("replyToPostId", post->replyToPostId);
-        grp.writeEntry("replyToUserId", post->replyToUser.userId);
-        grp.writeEntry("repeatedFromUserId", post->repeatedFromUser.userId);
-        grp.writeEntry("repeatedFromUserName", post->repeatedFromUser.userName);
-        grp.writeEntry("repeatedFromUserHomePage", post->repeatedFromUser.homePageUrl);
-        grp.writeEntry("repeatedPostId", post->repeatedPostId);
-        grp.writeEntry("repeatedDateTime", post->repeatedDateTime);
-    }
-    postsBackup.sync();
+    Choqok::MicroBlog::saveTimeline(account, timelineName, timeline);
 
     if (Choqok::Application::isShuttingDown()) {
         --d->countOfTimelinesToSave;
@@ -668,6 +637,11 @@ Choqok::UI::PostWidget *MastodonMicroBlog::createPostWidget(Choqok::Account *acc
     return new MastodonPostWidget(account, post, parent);
 }
 
+Choqok::Post *MastodonMicroBlog::newPost() const
+{
+    return new MastodonPost;
+}
+
 void MastodonMicroBlog::fetchPost(Choqok::Account *theAccount, Choqok::Post *post)
 {
     MastodonAccount *acc = qobject_cast<MastodonAccount *>(theAccount);
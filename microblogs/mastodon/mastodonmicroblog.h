@@ -53,10 +53,14 @@ public:
                                                     Choqok::Post *post,
                                                     QWidget *parent) override;
 
+    virtual Choqok::Post *newPost() const override;
+
     virtual void fetchPost(Choqok::Account *theAccount, Choqok::Post *post) override;
 
     virtual QList<Choqok::Post * > loadTimeline(Choqok::Account *account,
-                                                const QString &timelineName) override;
+                                                const QString &timelineName,
+                                                int count = -1,
+                                                const Choqok::Post *before = nullptr) override;
 
     virtual void removePost(Choqok::Account *theAccount, Choqok::Post *post) override;
 
@@ -114,6 +118,9 @@ protected:
 
     QString authorizationMetaData(MastodonAccount *account) const;
 
+    virtual QList<Choqok::Post *> loadTimelineBackup(Choqok::Account *account,
+                                                      const QString &timelineName) override;
+
     QString lastTimelineId(Choqok::Account *theAccount, const QString &timeline) const;
 
     Choqok::Post *readPost(const QVariantMap &var, Choqok::Post *post);
@@ -36,7 +36,7 @@
 #include "mastodonmicroblog.h"
 #include "mastodonpost.h"
 
-const QIcon MastodonPostWidget::unFavIcon(Choqok::MediaManager::convertToGrayScale(QIcon::fromTheme(QLatin1String("rating")).pixmap(16)));
+const QIcon MastodonPostWidget::unFavIcon(Choqok::MediaManager::grayScaleIcon(QLatin1String("rating"), 16));
 
 class MastodonPostWidget::Private
 {
@@ -184,10 +184,13 @@ void MastodonPostWidget::toggleFavorite()
     microBlog->toggleFavorite(currentAccount(), currentPost());
 }
 
-void MastodonPostWidget::slotToggleFavorite(Choqok::Account *, Choqok::Post *)
+void MastodonPostWidget::slotToggleFavorite(Choqok::Account *, Choqok::Post *post)
 {
     qCDebug(CHOQOK);
     updateFavStat();
+    if (post->postId == currentPost()->postId) {
+        Q_EMIT postChanged();
+    }
 }
 
 void MastodonPostWidget::updateFavStat()
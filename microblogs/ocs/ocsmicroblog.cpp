@@ -61,37 +61,13 @@ void OCSMicroblog::saveTimeline(Choqok::Account *account, const QString &timelin
                                 const QList< Choqok::UI::PostWidget * > &timeline)
 {
     qCDebug(CHOQOK);
-    QString fileName = Choqok::AccountManager::generatePostBackupFileName(account->alias(), timelineName);
-    KConfig postsBackup(fileName, KConfig::NoGlobals, QStandardPaths::DataLocation);
-
-    ///Clear previous data:
-    for (const QString &group: postsBackup.groupList()) {
-        postsBackup.deleteGroup(group);
-    }
-
-    for (Choqok::UI::PostWidget *wd: timeline) {
-        const Choqok::Post *post = wd->currentPost();
-        KConfigGroup grp(&postsBackup, post->creationDateTime.toString());
-        grp.writeEntry("creationDateTime", post->creationDateTime);
-        grp.writeEntry("postId", post->postId);
-        grp.writeEntry("text", post->content);
-        grp.writeEntry("authorId", post->author.userId);
-        grp.writeEntry("authorUserName", post->author.userName);
-        grp.writeEntry("authorRealName", post->author.realName);
-        grp.writeEntry("authorProfileImageUrl", post->author.profileImageUrl);
-        grp.writeEntry("authorDescription" , post->author.description);
-        grp.writeEntry("authorLocation" , post->author.location);
-        grp.writeEntry("authorUrl" , post->author.homePageUrl);
-        grp.writeEntry("link", post->link);
-        grp.writeEntry("isRead" , post->isRead);
-    }
-    postsBackup.sync();
+    Choqok::MicroBlog::saveTimeline(account, timelineName, timeline);
     if (Choqok::Application::isShuttingDown()) {
         Q_EMIT readyForUnload();
     }
 }
 
-QList< Choqok::Post * > OCSMicroblog::loadTimeline(Choqok::Account *account, const QString &timelineName)
+QList< Choqok::Post * > OCSMicroblog::loadTimelineBackup(Choqok::Account *account, const QString &timelineName)
 {
     qCDebug(CHOQOK) << timelineName;
     QList< Choqok::Post * > list;
@@ -99,17 +75,12 @@ QList< Choqok::Post * > OCSMicroblog::loadTimeline(Choqok::Account *account, con
     KConfig postsBackup(fileName, KConfig::NoGlobals, QStandardPaths::DataLocation);
     QStringList tmpList = postsBackup.groupList();
 
-    QList<QDateTime> groupList;
-    for (const QString &str: tmpList) {
-        groupList.append(QDateTime::fromString(str));
-    }
-    std::sort(groupList.begin(), groupList.end());
-    int count = groupList.count();
+    int count = tmpList.count();
     if (count) {
         Choqok::Post *st = nullptr;
         for (int i = 0; i < count; ++i) {
             st = new Choqok::Post;
-            KConfigGroup grp(&postsBackup, groupList[i].toString());
+            KConfigGroup grp(&postsBackup, tmpList[i]);
             st->creationDateTime = grp.readEntry("creationDateTime", QDateTime::currentDateTime());
             st->postId = grp.readEntry("postId", QString());
             st->content = grp.readEntry("text", QString());
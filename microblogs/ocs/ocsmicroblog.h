@@ -47,7 +47,6 @@ public:
     virtual void removePost(Choqok::Account *theAccount, Choqok::Post *post) override;
     virtual void saveTimeline(Choqok::Account *account, const QString &timelineName,
                               const QList< Choqok::UI::PostWidget * > &timeline) override;
-    virtual QList< Choqok::Post * > loadTimeline(Choqok::Account *account, const QString &timelineName) override;
     virtual Choqok::Account *createNewAccount(const QString &alias) override;
     virtual void updateTimelines(Choqok::Account *theAccount) override;
     virtual Choqok::TimelineInfo *timelineInfo(const QString &timelineName) override;
@@ -62,6 +61,9 @@ public:
 Q_SIGNALS:
     void initialized();
 
+protected:
+    virtual QList< Choqok::Post * > loadTimelineBackup(Choqok::Account *account, const QString &timelineName) override;
+
 protected Q_SLOTS:
     void slotTimelineLoaded(Attica::BaseJob *);
     void slotCreatePost(Attica::BaseJob *);
@@ -36,6 +36,7 @@
 #include "accountmanager.h"
 #include "application.h"
 #include "choqokbehaviorsettings.h"
+#include "choqoktools.h"
 #include "notifymanager.h"
 
 #include "pumpioaccount.h"
@@ -316,6 +317,37 @@ Choqok::UI::PostWidget *PumpIOMicroBlog::createPostWidget(Choqok::Account *accou
     return new PumpIOPostWidget(account, post, parent);
 }
 
+Choqok::Post *PumpIOMicroBlog::newPost() const
+{
+    return new PumpIOPost;
+}
+
+QVariantMap PumpIOMicroBlog::postExtras(const Choqok::Post *post) const
+{
+    QVariantMap extras;
+    const PumpIOPost *p = dynamic_cast<const PumpIOPost *>(post);
+    if (p) {
+        extras[QLatin1String("replies")] = p->replies;
+        extras[QLatin1String("shares")] = p->shares;
+        extras[QLatin1String("to")] = p->to;
+        extras[QLatin1String("cc")] = p->cc;
+        extras[QLatin1String("replyToObjectType")] = p->replyToObjectType;
+    }
+    return extras;
+}
+
+void PumpIOMicroBlog::setPostExtras(Choqok::Post *post, const QVariantMap &extras) const
+{
+    PumpIOPost *p = dynamic_cast<PumpIOPost *>(post);
+    if (p) {
+        p->replies = extras.value(QLatin1String("replies")).toUrl();
+        p->shares = extras.value(QLatin1String("shares")).toStringList();
+        p->to = extras.value(QLatin1String("to")).toStringList();
+        p->cc = extras.value(QLatin1String("cc")).toStringList();
+        p->replyToObjectType = extras.value(QLatin1String("replyToObjectType")).toString();
+    }
+}
+
 void PumpIOMicroBlog::fetchPost(Choqok::Account *theAccount, Choqok::Post *post)
 {
     PumpIOAccount *acc = qobject_cast<PumpIOAccount *>(theAccount);
@@ -373,7 +405,7 @@ void PumpIOMicroBlog::removePost(Choqok::Account *theAccount, Choqok::Post *post
     }
 }
 
-QList< Choqok::Post * > PumpIOMicroBlog::loadTimeline(Choqok::Account *account,
+QList< Choqok::Post * > PumpIOMicroBlog::loadTimelineBackup(Choqok::Account *account,
         const QString &timelineName)
 {
     QList< Choqok::Post * > list;
@@ -387,15 +419,10 @@ QList< Choqok::Post * > PumpIOMicroBlog::loadTimeline(Choqok::Account *account,
         return list;
     }
 
-    QList<QDateTime> groupList;
-    for (const QString &str: tmpList) {
-        groupList.append(QDateTime::fromString(str));
-    }
-    std::sort(groupList.begin(), groupList.end());
     PumpIOPost *st;
-    for (const QDateTime &datetime: groupList) {
+    for (const QString &group: tmpList) {
         st = new PumpIOPost;
-        KConfigGroup grp(&postsBackup, datetime.toString());
+        KConfigGroup grp(&postsBackup, group);
         st->creationDateTime = grp.readEntry("creationDateTime", QDateTime::currentDateTime());
         st->postId = grp.readEntry("postId", QString());
         st->link = grp.readEntry("link", QUrl());
@@ -423,10 +450,16 @@ QList< Choqok::Post * > PumpIOMicroBlog::loadTimeline(Choqok::Account *account,
         list.append(st);
     }
 
-    if (!list.isEmpty()) {
+    return list;
+}
+
+QList<Choqok::Post *> PumpIOMicroBlog::loadTimeline(Choqok::Account *account, const QString &timelineName,
+        int count, const Choqok::Post *before)
+{
+    const QList<Choqok::Post *> list = Choqok::MicroBlog::loadTimeline(account, timelineName, count, before);
+    if (!before && !list.isEmpty()) {
         setLastTimelineId(account, timelineName, list.last()->conversationId);
     }
-
     return list;
 }
 
@@ -454,44 +487,7 @@ QUrl PumpIOMicroBlog::profileUrl(Choqok::Account *account, const QString &userna
 void PumpIOMicroBlog::saveTimeline(Choqok::Account *account, const QString &timelineName,
                                    const QList< Choqok::UI::PostWidget * > &timeline)
 {
-    const QString fileName = Choqok::AccountManager::generatePostBackupFileName(account->alias(),
-                             timelineName);
-    KConfig postsBackup(fileName, KConfig::NoGlobals, QStandardPaths::DataLocation);
-
-    ///Clear previous data:
-    for (const QString &group: postsBackup.groupList()) {
-        postsBackup.deleteGroup(group);
-    }
-
-    for (Choqok::UI::PostWidget *wd: timeline) {
-        PumpIOPost *post = dynamic_cast<PumpIOPost * >(wd->currentPost());
-        KConfigGroup grp(&postsBackup, post->creationDateTime.toString());
-        grp.writeEntry("creationDateTime", post->creationDateTime);
-        grp.writeEntry("postId", post->postId);
-        grp.writeEntry("link", post->link);
-        grp.writeEntry("content", post->content);
-        grp.writeEntry("source", post->source);
-        grp.writeEntry("favorited", post->isFavorited);
-        grp.writeEntry("authorId", post->author.userId);
-        grp.writeEntry("authorRealName", post->author.realName);
-        grp.writeEntry("authorUserName", post->author.userName);
-        grp.writeEntry("authorLocation", post->author.location);
-        grp.writeEntry("authorDescription", post->author.description);
-        grp.writeEntry("authorProfileImageUrl", post->author.profileImageUrl);
-        grp.writeEntry("authorHomePageUrl", post->author.homePageUrl);
-        grp.writeEntry("type", post->type);
-        grp.writeEntry("media", post->media);
-        grp.writeEntry("isRead", post->isRead);
-        grp.writeEntry("conversationId", post->conversationId);
-        grp.writeEntry("to", post->to);
-        grp.writeEntry("cc", post->cc);
-        grp.writeEntry("shares", post->shares);
-        grp.writeEntry("replies", post->replies);
-        grp.writeEntry("replyToPostId", post->replyToPostId);
-        grp.writeEntry("replyToUserName", post->replyToUser.userName);
-        grp.writeEntry("replyToObjectType", post->replyToObjectType);
-    }
-    postsBackup.sync();
+    Choqok::MicroBlog::saveTimeline(account, timelineName, timeline);
 
     if (Choqok::Application::isShuttingDown()) {
         --d->countOfTimelinesToSave;
@@ -1135,6 +1131,7 @@ Choqok::Post *PumpIOMicroBlog::readPost(const QVariantMap &var, Choqok::Post *po
 
         content.setHtml(object[QLatin1String("content")].toString());
         p->content += content.toPlainText().trimmed();
+        p->direction = Choqok::textDirection(p->content);
 
         if (!object[QLatin1String("fullImage")].isNull()) {
             const QVariantMap fullImage = object[QLatin1String("fullImage")].toMap();
@@ -62,10 +62,18 @@ public:
                                                     Choqok::Post *post,
                                                     QWidget *parent) override;
 
+    virtual Choqok::Post *newPost() const override;
+
+    virtual QVariantMap postExtras(const Choqok::Post *post) const override;
+
+    virtual void setPostExtras(Choqok::Post *post, const QVariantMap &extras) const override;
+
     virtual void fetchPost(Choqok::Account *theAccount, Choqok::Post *post) override;
 
     virtual QList<Choqok::Post * > loadTimeline(Choqok::Account *account,
-                                                const QString &timelineName) override;
+                                                const QString &timelineName,
+                                                int count = -1,
+                                                const Choqok::Post *before = nullptr) override;
 
     virtual void removePost(Choqok::Account *theAccount, Choqok::Post *post) override;
 
@@ -127,6 +135,9 @@ protected:
     static const QString inboxActivity;
     static const QString outboxActivity;
 
+    virtual QList<Choqok::Post *> loadTimelineBackup(Choqok::Account *account,
+                                                      const QString &timelineName) override;
+
     QString lastTimelineId(Choqok::Account *theAccount, const QString &timeline) const;
 
     Choqok::Post *readPost(const QVariantMap &var, Choqok::Post *post);
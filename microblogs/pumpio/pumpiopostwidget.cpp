@@ -38,7 +38,7 @@
 #include "pumpiopost.h"
 #include "pumpioshowthread.h"
 
-const QIcon PumpIOPostWidget::unFavIcon(Choqok::MediaManager::convertToGrayScale(QIcon::fromTheme(QLatin1String("rating")).pixmap(16)));
+const QIcon PumpIOPostWidget::unFavIcon(Choqok::MediaManager::grayScaleIcon(QLatin1String("rating"), 16));
 
 class PumpIOPostWidget::Private
 {
@@ -212,10 +212,13 @@ void PumpIOPostWidget::toggleFavorite()
     microBlog->toggleFavorite(currentAccount(), currentPost());
 }
 
-void PumpIOPostWidget::slotToggleFavorite(Choqok::Account *, Choqok::Post *)
+void PumpIOPostWidget::slotToggleFavorite(Choqok::Account *, Choqok::Post *post)
 {
     qCDebug(CHOQOK);
     updateFavStat();
+    if (post->postId == currentPost()->postId) {
+        Q_EMIT postChanged();
+    }
 }
 
 void PumpIOPostWidget::slotPostError(Choqok::Account *theAccount, Choqok::Post *post,
@@ -25,7 +25,6 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include <QAction>
 #include <QJsonDocument>
 #include <QMenu>
-#include <QMimeDatabase>
 
 #include <KIO/StoredTransferJob>
 #include <KLocalizedString>
@@ -36,10 +35,13 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include "accountmanager.h"
 #include "choqokappearancesettings.h"
 #include "choqokbehaviorsettings.h"
+#include "choqoktools.h"
 #include "choqoktypes.h"
 #include "composerwidget.h"
 #include "editaccountwidget.h"
 #include "mediamanager.h"
+#include "mediumreadjob.h"
+#include "multipartformdata.h"
 #include "postwidget.h"
 #include "timelinewidget.h"
 
@@ -150,62 +152,65 @@ void TwitterMicroBlog::createPostWithAttachment(Choqok::Account *theAccount, Cho
     if (mediumToAttach.isEmpty()) {
         TwitterApiMicroBlog::createPost(theAccount, post);
     } else {
-        const QUrl picUrl = QUrl::fromUserInput(mediumToAttach);
-        KIO::StoredTransferJob *picJob = KIO::storedGet(picUrl, KIO::Reload, KIO::HideProgressInfo);
-        picJob->exec();
-        if (picJob->error()) {
-            qCCritical(CHOQOK) << "Job error:" << picJob->errorString();
-            KMessageBox::detailedError(Choqok::UI::Global::mainWindow(),
-                                       i18n("Uploading medium failed: cannot read the medium file."),
-                                       picJob->errorString());
-            return;
-        }
-        const QByteArray picData = picJob->data();
-        if (picData.count() == 0) {
-            qCCritical(CHOQOK) << "Cannot read the media file, please check if it exists.";
-            KMessageBox::error(Choqok::UI::Global::mainWindow(),
-                               i18n("Uploading medium failed: cannot read the medium file."));
-            return;
-        }
+        Choqok::MediumReadJob *readJob = new Choqok::MediumReadJob(QUrl::fromUserInput(mediumToAttach), this);
+        mCreatePostMap[readJob] = post;
+        mJobsAccount[readJob] = theAccount;
+        connect(readJob, &KJob::result, this, &TwitterMicroBlog::slotAttachmentRead);
+        readJob->start();
+    }
+}
 
-        TwitterAccount *account = qobject_cast<TwitterAccount *>(theAccount);
-        QUrl url = account->uploadUrl();
-        url.setPath(url.path() + QLatin1String("/statuses/update_with_media.json"));
-        const QMimeDatabase db;
-        QByteArray fileContentType = db.mimeTypeForUrl(picUrl).name().toUtf8();
+void TwitterMicroBlog::slotAttachmentRead(KJob *readJob)
+{
+    Choqok::Post *post = mCreatePostMap.take(readJob);
+    Choqok::Account *theAccount = mJobsAccount.take(readJob);
+    if (!post || !theAccount) {
+        qCDebug(CHOQOK) << "Account or Post is NULL pointer";
+        return;
+    }
+    if (readJob->error()) {
+        qCCritical(CHOQOK) << "Job error:" << readJob->errorString();
+        Q_EMIT errorPost(theAccount, post, Choqok::MicroBlog::OtherError,
+                         i18n("Uploading medium failed: cannot read the medium file: %1", readJob->errorString()),
+                         MicroBlog::Critical);
+        return;
+    }
+    Choqok::MediumReadJob *medium = qobject_cast<Choqok::MediumReadJob *>(readJob);
+    const QUrl picUrl = medium->url();
 
-        QMap<QString, QByteArray> formdata;
-        formdata[QLatin1String("status")] = post->content.toUtf8();
-        if (!post->replyToPostId.isEmpty()) {
-            formdata[QLatin1String("in_reply_to_status_id")] = post->replyToPostId.toLatin1();
-        }
-        formdata[QLatin1String("source")] = QCoreApplication::applicationName().toLatin1();
-
-        QMap<QString, QByteArray> mediafile;
-        mediafile[QLatin1String("name")] = "media[]";
-        mediafile[QLatin1String("filename")] = picUrl.fileName().toUtf8();
-        mediafile[QLatin1String("mediumType")] = fileContentType;
-        mediafile[QLatin1String("medium")] = picData;
-        QList< QMap<QString, QByteArray> > listMediafiles;
-        listMediafiles.append(mediafile);
-
-        QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
-
-        KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
-        if (!job) {
-            qCCritical(CHOQOK) << "Cannot create a http POST request!";
-            return;
-        }
-        job->addMetaData(QStringLiteral("content-type"),
-                         QStringLiteral("Content-Type: multipart/form-data; boundary=AaB03x"));
-        job->addMetaData(QStringLiteral("customHTTPHeader"),
-                         QStringLiteral("Authorization: ") +
-                         QLatin1String(authorizationHeader(account, url, QNetworkAccessManager::PostOperation)));
-        mCreatePostMap[ job ] = post;
-        mJobsAccount[job] = theAccount;
-        connect(job, &KIO::StoredTransferJob::result, this, &TwitterMicroBlog::slotCreatePost);
-        job->start();
+    TwitterAccount *account = qobject_cast<TwitterAccount *>(theAccount);
+    QUrl url = account->uploadUrl();
+    url.setPath(url.path() + QLatin1String("/statuses/update_with_media.json"));
+
+    QMap<QString, QByteArray> formdata;
+    formdata[QLatin1String("status")] = post->content.toUtf8();
+    if (!post->replyToPostId.isEmpty()) {
+        formdata[QLatin1String("in_reply_to_status_id")] = post->replyToPostId.toLatin1();
+    }
+    formdata[QLatin1String("source")] = QCoreApplication::applicationName().toLatin1();
+
+    Choqok::MultipartFormData *form = new Choqok::MultipartFormData;
+    if (!form->addFile(QLatin1String("media[]"), picUrl, medium->mimeType(), medium->data())) {
+        delete form;
+        Q_EMIT errorPost(theAccount, post, Choqok::MicroBlog::OtherError,
+                         i18n("Uploading medium failed: the medium file is empty or cannot be read."),
+                         MicroBlog::Critical);
+        return;
     }
+    form->addFields(formdata);
+
+    KIO::StoredTransferJob *job = form->post(url);
+    if (!job) {
+        qCCritical(CHOQOK) << "Cannot create a http POST request!";
+        return;
+    }
+    job->addMetaData(QStringLiteral("customHTTPHeader"),
+                     QStringLiteral("Authorization: ") +
+                     QLatin1String(authorizationHeader(account, url, QNetworkAccessManager::PostOperation)));
+    mCreatePostMap[ job ] = post;
+    mJobsAccount[job] = theAccount;
+    connect(job, &KIO::StoredTransferJob::result, this, &TwitterMicroBlog::slotCreatePost);
+    job->start();
 }
 
 void TwitterMicroBlog::verifyCredentials(TwitterAccount *theAccount)
@@ -470,6 +475,7 @@ Choqok::Post *TwitterMicroBlog::readPost(Choqok::Account *account, const QVarian
     // Support for extended tweet_mode
     if (var.contains(QLatin1String("full_text")) && post->repeatedPostId.isEmpty()) {
         post->content = var[QLatin1String("full_text")].toString();
+        post->direction = Choqok::textDirection(post->content);
     }
 
     //postId is changed, regenerate link url
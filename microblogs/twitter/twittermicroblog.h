@@ -85,6 +85,7 @@ protected Q_SLOTS:
     void showListDialog(TwitterApiAccount *theAccount = nullptr);
     void slotFetchUserLists(KJob *job);
     void slotFetchVerifyCredentials(KJob *job);
+    void slotAttachmentRead(KJob *readJob);
 
 protected:
     virtual void requestTimeLine(Choqok::Account *theAccount, QString timelineName,
@@ -62,7 +62,11 @@ void TwitterPostWidget::initUi()
                                                  Choqok::MediaManager::self()->defaultImage());
         }
         
-        auto dir = getDirection(currentPost()->quotedPost.content);
+        Choqok::QuotedPost &quotedPost = currentPost()->quotedPost;
+        if (quotedPost.direction == Qt::LayoutDirectionAuto) {
+            quotedPost.direction = Choqok::textDirection(quotedPost.content);
+        }
+        auto dir = QLatin1String(quotedPost.direction == Qt::RightToLeft ? "rtl" : "ltr");
         auto text = prepareStatus(currentPost()->quotedPost.content);
         QString user = QStringLiteral("<a href='user://%1'>%1</a>").arg(currentPost()->quotedPost.user.userName);
         QString quoteText = mQuotedTextBase.arg(text, dir, user, QLatin1String("background-color:%1;"));
@@ -244,15 +248,11 @@ void TwitterPostWidget::checkAnchor(const QUrl &url)
 bool TwitterPostWidget::setupQuotedAvatar()
 {
     QPixmap pix = Choqok::MediaManager::self()->fetchImage(currentPost()->quotedPost.user.profileImageUrl,
-                                                           Choqok::MediaManager::Async);
+                                                           this, "quotedAvatarFetched", "quotedAvatarFetchError");
     if (!pix.isNull()) {
         quotedAvatarFetched(currentPost()->quotedPost.user.profileImageUrl, pix);
         return true;
     } else {
-        connect(Choqok::MediaManager::self(), &Choqok::MediaManager::imageFetched,
-                this, &TwitterPostWidget::quotedAvatarFetched);
-        connect(Choqok::MediaManager::self(), &Choqok::MediaManager::fetchError,
-                this, &TwitterPostWidget::quotedAvatarFetchError);
         return false;
     }
 }
@@ -261,10 +261,6 @@ void TwitterPostWidget::quotedAvatarFetched(const QUrl &remoteUrl, const QPixmap
 {
     if (remoteUrl == currentPost()->quotedPost.user.profileImageUrl) {
         _mainWidget->document()->addResource(QTextDocument::ImageResource, mQuotedAvatarResourceUrl, pixmap);
-        disconnect(Choqok::MediaManager::self(), &Choqok::MediaManager::imageFetched,
-                   this, &TwitterPostWidget::quotedAvatarFetched);
-        disconnect(Choqok::MediaManager::self(), &Choqok::MediaManager::fetchError,
-                   this, &TwitterPostWidget::quotedAvatarFetchError);
     }
 }
 
@@ -272,7 +268,7 @@ void TwitterPostWidget::quotedAvatarFetchError(const QUrl &remoteUrl, const QStr
 {
     Q_UNUSED(errMsg);
     if (remoteUrl == currentPost()->quotedPost.user.profileImageUrl) {
-        ///Avatar fetching is failed! but will not disconnect to get the img if it fetches later!
+        ///Avatar fetching is failed!
         _mainWidget->document()->addResource(QTextDocument::ImageResource, mQuotedAvatarResourceUrl,
                                              QIcon::fromTheme(QLatin1String("image-missing")).pixmap(40));
     }
@@ -280,21 +276,12 @@ void TwitterPostWidget::quotedAvatarFetchError(const QUrl &remoteUrl, const QStr
 
 QString TwitterPostWidget::getBackgroundColor()
 {
-    QString style = styleSheet();
-    QLatin1String str{ "background-color:rgb(" };
-    int idx = style.indexOf(str);
-    if(idx != -1){
-        idx += str.size();
-        int endIdx = style.indexOf(QLatin1String(");"), idx);
-        if( endIdx != -1 ){
-            QStringList rgb = style.mid(idx, endIdx-idx).split(QLatin1Char(','));
-            if( rgb.size() == 3 ){
-                return QStringLiteral("#%1%2%3").arg( rgb[0].toInt() - 20, 2, 16, QLatin1Char('0') )
-                                                .arg( rgb[1].toInt() - 20, 2, 16, QLatin1Char('0') )
-                                                .arg( rgb[2].toInt() - 20, 2, 16, QLatin1Char('0') );
-            }
-        }
+    const QColor color = backgroundColor();
+    if (color.isValid()) {
+        return QStringLiteral("#%1%2%3").arg( color.red() - 20, 2, 16, QLatin1Char('0') )
+                                        .arg( color.green() - 20, 2, 16, QLatin1Char('0') )
+                                        .arg( color.blue() - 20, 2, 16, QLatin1Char('0') );
     }
-    
+
     return QLatin1String("#ffffff");
 }
@@ -34,8 +34,6 @@
 
 #include "notifysettings.h"
 
-const QRegExp Notification::dirRegExp(QLatin1String("(RT|RD)|(@([^\\s\\W]+))|(#([^\\s\\W]+))|(!([^\\s\\W]+))"));
-
 Notification::Notification(Choqok::UI::PostWidget *postWidget)
     : QWidget(), post(postWidget), dir(QLatin1String("ltr"))
 {
@@ -130,10 +128,11 @@ void Notification::setHeight()
 
 void Notification::setDirection()
 {
-    QString txt = post->currentPost()->content;
-    txt.remove(dirRegExp);
-    txt = txt.trimmed();
-    if (txt.isRightToLeft()) {
+    Choqok::Post *currentPost = post->currentPost();
+    if (currentPost->direction == Qt::LayoutDirectionAuto) {
+        currentPost->direction = Choqok::textDirection(currentPost->content);
+    }
+    if (currentPost->direction == Qt::RightToLeft) {
         dir = QLatin1String("rtl");
     }
 }
@@ -53,7 +53,6 @@ protected:
 private:
     void setDirection();
     void setHeight();
-    static const QRegExp dirRegExp;
     Choqok::UI::PostWidget *post;
     QString dir;
     MyTextBrowser mainWidget;
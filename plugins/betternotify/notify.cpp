@@ -45,8 +45,8 @@ Notify::Notify(QObject *parent, const QList< QVariant > &)
     NotifySettings set;
     accountsList = set.accounts();
     timer.setInterval(set.notifyInterval() * 1000);
-    connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetAdded,
-            this, &Notify::slotNewPostWidgetAdded);
+    connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetsAdded,
+            this, &Notify::slotNewPostWidgetsAdded);
     connect(&timer, &QTimer::timeout, this, &Notify::notifyNextPost);
 
     notifyPosition = set.position();
@@ -56,21 +56,26 @@ Notify::~Notify()
 {
 }
 
-void Notify::slotNewPostWidgetAdded(Choqok::UI::PostWidget *pw, Choqok::Account *acc, QString tm)
+void Notify::slotNewPostWidgetsAdded(const QList<Choqok::UI::PostWidget *> &widgets, Choqok::Account *acc, const QString &tm)
 {
 //     qDebug()<<Choqok::Application::isStartingUp()<< Choqok::Application::isShuttingDown();
     if (Choqok::Application::isStartingUp() || Choqok::Application::isShuttingDown()) {
         //qDebug()<<"Choqok is starting up or going down!";
         return;
     }
-    if (pw && !pw->isRead() && accountsList[acc->alias()].contains(tm)) {
-        //qDebug()<<"POST ADDED TO NOTIFY IT: "<<pw->currentPost()->content;
-        postQueueToNotify.enqueue(pw);
-        if (!timer.isActive()) {
-            notifyNextPost();
-            timer.start();
+    if (!accountsList[acc->alias()].contains(tm)) {
+        return;
+    }
+    for (Choqok::UI::PostWidget *pw: widgets) {
+        if (pw && !pw->isRead()) {
+            //qDebug()<<"POST ADDED TO NOTIFY IT: "<<pw->currentPost()->content;
+            postQueueToNotify.enqueue(pw);
         }
     }
+    if (!postQueueToNotify.isEmpty() && !timer.isActive()) {
+        notifyNextPost();
+        timer.start();
+    }
 }
 
 void Notify::notifyNextPost()
@@ -49,7 +49,7 @@ public:
     ~Notify();
 
 protected Q_SLOTS:
-    void slotNewPostWidgetAdded(Choqok::UI::PostWidget *, Choqok::Account *, QString);
+    void slotNewPostWidgetsAdded(const QList<Choqok::UI::PostWidget *> &, Choqok::Account *, const QString &);
     void notifyNextPost();
     void stopNotifications();
     void slotPostReaded();
@@ -24,7 +24,6 @@
 #include "filtermanager.h"
 
 #include <QAction>
-#include <QTimer>
 
 #include <KActionCollection>
 #include <KLocalizedString>
@@ -46,14 +45,15 @@ K_PLUGIN_FACTORY_WITH_JSON(FilterManagerFactory, "choqok_filter.json",
                            registerPlugin < FilterManager > ();)
 
 FilterManager::FilterManager(QObject *parent, const QList<QVariant> &)
-    : Choqok::Plugin(QLatin1String("choqok_filter"), parent), state(Stopped)
+    : Choqok::Plugin(QLatin1String("choqok_filter"), parent)
 {
     QAction *action = new QAction(i18n("Configure Filters..."), this);
     actionCollection()->addAction(QLatin1String("configureFilters"), action);
     connect(action, &QAction::triggered, this, &FilterManager::slotConfigureFilters);
     setXMLFile(QLatin1String("filterui.rc"));
-    connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetAdded,
-            this, &FilterManager::slotAddNewPostWidget);
+    // Filters only need post data, So posts are filtered before timelines show them
+    connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::postWidgetsAdding,
+            this, &FilterManager::slotAddNewPostWidgets);
 
     hidePost = new QAction(i18n("Hide Post"), this);
     Choqok::UI::PostWidget::addAction(hidePost);
@@ -65,27 +65,10 @@ FilterManager::~FilterManager()
 
 }
 
-void FilterManager::slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget)
+void FilterManager::slotAddNewPostWidgets(const QList<Choqok::UI::PostWidget *> &newWidgets)
 {
-    postsQueue.enqueue(newWidget);
-    if (state == Stopped) {
-        state = Running;
-        QTimer::singleShot(1000, this, SLOT(startParsing()));
-    }
-}
-
-void FilterManager::startParsing()
-{
-    int i = 8;
-    while (!postsQueue.isEmpty() && i > 0) {
-        parse(postsQueue.dequeue());
-        --i;
-    }
-
-    if (postsQueue.isEmpty()) {
-        state = Stopped;
-    } else {
-        QTimer::singleShot(500, this, SLOT(startParsing()));
+    for (Choqok::UI::PostWidget *newWidget: newWidgets) {
+        parse(newWidget);
     }
 }
 
@@ -175,16 +158,13 @@ Filter::FilterAction FilterManager::filterText(const QString &textToCheck, Filte
 
 void FilterManager::doFiltering(Choqok::UI::PostWidget *postToFilter, Filter::FilterAction action)
 {
-    QString css;
     switch (action) {
     case Filter::Remove:
         //qDebug() << "Post removed:" << postToFilter->currentPost()->content;
         postToFilter->close();
         break;
     case Filter::Highlight:
-        css = postToFilter->styleSheet();
-        css.replace(QLatin1String("border: 1px solid rgb(150,150,150)"), QLatin1String("border: 2px solid rgb(255,0,0)"));
-        postToFilter->setStyleSheet(css);
+        postToFilter->setHighlighted(true);
         break;
     case Filter::None:
     default:
@@ -24,7 +24,6 @@
 #define FILTERMANAGER_H
 
 #include <QPointer>
-#include <QQueue>
 
 #include "plugin.h"
 
@@ -52,20 +51,15 @@ public:
     ~FilterManager();
 
 protected Q_SLOTS:
-    void slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget);
-    void startParsing();
+    void slotAddNewPostWidgets(const QList<Choqok::UI::PostWidget *> &newWidgets);
     void slotConfigureFilters();
     void slotHidePost();
 
 private:
-    enum ParserState { Stopped = 0, Running };
-    ParserState state;
-
     Filter::FilterAction filterText(const QString &textToCheck, Filter *filter);
     void doFiltering(Choqok::UI::PostWidget *postToFilter, Filter::FilterAction action);
 
     void parse(Choqok::UI::PostWidget *postToParse);
-    QQueue< QPointer<Choqok::UI::PostWidget> > postsQueue;
 
     bool parseSpecialRules(Choqok::UI::PostWidget *postToParse);
 
@@ -35,6 +35,8 @@
 K_PLUGIN_FACTORY_WITH_JSON(ImagePreviewFactory, "choqok_imagepreview.json",
                            registerPlugin < ImagePreview > ();)
 
+static const int ThumbnailSize = 200;
+
 const QRegExp ImagePreview::mImgLyRegExp(QLatin1String("(http://img.ly/[^\\s<>\"]+[^!,\\.\\s<>'\"\\]])"));
 const QRegExp ImagePreview::mTwitgooRegExp(QLatin1String("(http://(([a-zA-Z0-9]+\\.)?)twitgoo.com/[^\\s<>\"]+[^!,\\.\\s<>'\"\\]])"));
 const QRegExp ImagePreview::mPumpIORegExp(QLatin1String("(https://([a-zA-Z0-9]+\\.)?[a-zA-Z0-9]+\\.[a-zA-Z]+/uploads/\\w+/\\d{4}/\\d{1,2}/\\d{1,2}/\\w+)(\\.[a-zA-Z]{3,4})"));
@@ -42,8 +44,8 @@ const QRegExp ImagePreview::mPumpIORegExp(QLatin1String("(https://([a-zA-Z0-9]+\
 ImagePreview::ImagePreview(QObject *parent, const QList< QVariant > &)
     : Choqok::Plugin(QLatin1String("choqok_imagepreview"), parent), state(Stopped)
 {
-    connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetAdded,
-            this, &ImagePreview::slotAddNewPostWidget);
+    connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetsAdded,
+            this, &ImagePreview::slotAddNewPostWidgets);
 }
 
 ImagePreview::~ImagePreview()
@@ -51,9 +53,11 @@ ImagePreview::~ImagePreview()
 
 }
 
-void ImagePreview::slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget)
+void ImagePreview::slotAddNewPostWidgets(const QList<Choqok::UI::PostWidget *> &newWidgets)
 {
-    postsQueue.enqueue(newWidget);
+    for (Choqok::UI::PostWidget *newWidget: newWidgets) {
+        postsQueue.enqueue(newWidget);
+    }
     if (state == Stopped) {
         state = Running;
         QTimer::singleShot(1000, this, SLOT(startParsing()));
@@ -93,12 +97,14 @@ void ImagePreview::parse(Choqok::UI::PostWidget *postToParse)
         ImgLyRedirectList << mImgLyRegExp.cap(0);
     }
     for (const QString &url: ImgLyRedirectList) {
-        connect(Choqok::MediaManager::self(),&Choqok::MediaManager::imageFetched,
-                this, &ImagePreview::slotImageFetched);
         QUrl ImgLyUrl = QUrl::fromUserInput(QStringLiteral("http://img.ly/show/thumb%1").arg(QString(url).remove(QLatin1String("http://img.ly"))));
         mParsingList.insert(ImgLyUrl, postToParse);
         mBaseUrlMap.insert(ImgLyUrl, url);
-        Choqok::MediaManager::self()->fetchImage(ImgLyUrl, Choqok::MediaManager::Async);
+        const QPixmap pixmap = Choqok::MediaManager::self()->fetchImage(ImgLyUrl, this, "slotImageFetched", nullptr,
+                                                                        QSize(ThumbnailSize, ThumbnailSize));
+        if (!pixmap.isNull()) {
+            slotImageFetched(ImgLyUrl, pixmap);
+        }
     }
 
     //Twitgoo; http://twitgoo.com/docs/TwitgooHelp.htm
@@ -108,12 +114,14 @@ void ImagePreview::parse(Choqok::UI::PostWidget *postToParse)
         TwitgooRedirectList << mTwitgooRegExp.cap(0);
     }
     for (const QString &url: TwitgooRedirectList) {
-        connect(Choqok::MediaManager::self(), &Choqok::MediaManager::imageFetched,
-                this, &ImagePreview::slotImageFetched);
         QUrl TwitgooUrl = QUrl::fromUserInput(url + QLatin1String("/thumb"));
         mParsingList.insert(TwitgooUrl, postToParse);
         mBaseUrlMap.insert(TwitgooUrl, url);
-        Choqok::MediaManager::self()->fetchImage(TwitgooUrl, Choqok::MediaManager::Async);
+        const QPixmap pixmap = Choqok::MediaManager::self()->fetchImage(TwitgooUrl, this, "slotImageFetched", nullptr,
+                                                                        QSize(ThumbnailSize, ThumbnailSize));
+        if (!pixmap.isNull()) {
+            slotImageFetched(TwitgooUrl, pixmap);
+        }
     }
 
     //PumpIO
@@ -127,12 +135,14 @@ void ImagePreview::parse(Choqok::UI::PostWidget *postToParse)
         imageExtension = mPumpIORegExp.cap(mPumpIORegExp.capturedTexts().length() - 1);
     }
     for (const QString &url: PumpIORedirectList) {
-        connect(Choqok::MediaManager::self(), &Choqok::MediaManager::imageFetched,
-                this, &ImagePreview::slotImageFetched);
         const QUrl pumpIOUrl = QUrl::fromUserInput(baseUrl + QLatin1String("_thumb") + imageExtension);
         mParsingList.insert(pumpIOUrl, postToParse);
         mBaseUrlMap.insert(pumpIOUrl, url);
-        Choqok::MediaManager::self()->fetchImage(pumpIOUrl, Choqok::MediaManager::Async);
+        const QPixmap pixmap = Choqok::MediaManager::self()->fetchImage(pumpIOUrl, this, "slotImageFetched", nullptr,
+                                                                        QSize(ThumbnailSize, ThumbnailSize));
+        if (!pixmap.isNull()) {
+            slotImageFetched(pumpIOUrl, pixmap);
+        }
     }
 }
 
@@ -148,10 +158,10 @@ void ImagePreview::slotImageFetched(const QUrl &remoteUrl, const QPixmap &pixmap
     imgU.setScheme(QLatin1String("img"));
 //     imgUrl.replace("http://","img://");
     QPixmap pix = pixmap;
-    if (pixmap.width() > 200) {
-        pix = pixmap.scaledToWidth(200);
-    } else if (pixmap.height() > 200) {
-        pix = pixmap.scaledToHeight(200);
+    if (pixmap.width() > ThumbnailSize) {
+        pix = pixmap.scaledToWidth(ThumbnailSize);
+    } else if (pixmap.height() > ThumbnailSize) {
+        pix = pixmap.scaledToHeight(ThumbnailSize);
     }
     postToParse->mainWidget()->document()->addResource(QTextDocument::ImageResource, imgU, pix);
     content.replace(QRegExp(QLatin1Char('>') + baseUrl + QLatin1Char('<')), QStringLiteral("><img align='left' src='")
@@ -46,7 +46,7 @@ public:
     ~ImagePreview();
 
 protected Q_SLOTS:
-    void slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget);
+    void slotAddNewPostWidgets(const QList<Choqok::UI::PostWidget *> &newWidgets);
     void startParsing();
     void slotImageFetched(const QUrl &remoteUrl, const QPixmap &pixmap);
 
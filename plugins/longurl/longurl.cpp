@@ -45,9 +45,9 @@ LongUrl::LongUrl(QObject *parent, const QList< QVariant > &)
 {
     sheduleSupportedServicesFetch();
     connect(Choqok::UI::Global::SessionManager::self(),
-            SIGNAL(newPostWidgetAdded(Choqok::UI::PostWidget*,Choqok::Account*,QString)),
+            SIGNAL(newPostWidgetsAdded(QList<Choqok::UI::PostWidget*>,Choqok::Account*,QString)),
             this,
-            SLOT(slotAddNewPostWidget(Choqok::UI::PostWidget*)));
+            SLOT(slotAddNewPostWidgets(QList<Choqok::UI::PostWidget*>)));
 }
 
 LongUrl::~LongUrl()
@@ -194,9 +194,11 @@ void LongUrl::jobResult(KJob *job)
     mParsingList.remove(job);
 }
 
-void LongUrl::slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget)
+void LongUrl::slotAddNewPostWidgets(const QList<Choqok::UI::PostWidget *> &newWidgets)
 {
-    postsQueue.enqueue(newWidget);
+    for (Choqok::UI::PostWidget *newWidget: newWidgets) {
+        postsQueue.enqueue(newWidget);
+    }
     if (state == Stopped && !mServicesAreFetched) {
         state = Running;
         QTimer::singleShot(1000, this, SLOT(startParsing()));
@@ -52,7 +52,7 @@ public:
     ~LongUrl();
 
 protected Q_SLOTS:
-    void slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget);
+    void slotAddNewPostWidgets(const QList<Choqok::UI::PostWidget *> &newWidgets);
     void startParsing();
     void dataReceived(KIO::Job *job, QByteArray data);
     void jobResult(KJob *job);
@@ -76,8 +76,8 @@ void QuickFilter::filterByAuthor()
                 postwidget->show();
             }
         }
-        connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetAdded,
-                this, &QuickFilter::filterNewPost);
+        connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::postWidgetsAdding,
+                this, &QuickFilter::filterNewPosts, Qt::UniqueConnection);
     } else {
         showAllPosts();
     }
@@ -95,8 +95,8 @@ void QuickFilter::filterByContent()
                 postwidget->show();
             }
         }
-        connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetAdded,
-                this, &QuickFilter::filterNewPost);
+        connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::postWidgetsAdding,
+                this, &QuickFilter::filterNewPosts, Qt::UniqueConnection);
     } else {
         showAllPosts();
     }
@@ -193,9 +193,17 @@ void QuickFilter::showAllPosts()
         }
         m_aledit->clear();
         m_tledit->clear();
-        disconnect(Choqok::UI::Global::SessionManager::self(),
-                   SIGNAL(newPostWidgetAdded(Choqok::UI::PostWidget*,Choqok::Account*,QString)),
-                   this, SLOT(filterNewPost(Choqok::UI::PostWidget*,Choqok::Account*,QString)));
+        disconnect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::postWidgetsAdding,
+                   this, &QuickFilter::filterNewPosts);
+    }
+}
+
+void QuickFilter::filterNewPosts(const QList<Choqok::UI::PostWidget *> &widgets, Choqok::Account *acc,
+                                 const QString &timeline)
+{
+    // Posts are hidden before timeline initializes and shows them
+    for (Choqok::UI::PostWidget *np: widgets) {
+        filterNewPost(np, acc, timeline);
     }
 }
 
@@ -58,6 +58,7 @@ protected Q_SLOTS:
     void filterByAuthor();
     void filterByContent();
     void filterNewPost(Choqok::UI::PostWidget *, Choqok::Account *, QString);
+    void filterNewPosts(const QList<Choqok::UI::PostWidget *> &, Choqok::Account *, const QString &);
 
 private Q_SLOTS:
     void updateUser(QString user);
@@ -42,8 +42,8 @@ UnTiny::UnTiny(QObject* parent, const QList< QVariant >& )
     : Choqok::Plugin(QLatin1String("choqok_untiny"), parent)
     , state(Stopped)
 {
-    connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetAdded,
-            this, &UnTiny::slotAddNewPostWidget);
+    connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetsAdded,
+            this, &UnTiny::slotAddNewPostWidgets);
 }
 
 UnTiny::~UnTiny()
@@ -51,9 +51,11 @@ UnTiny::~UnTiny()
 
 }
 
-void UnTiny::slotAddNewPostWidget(Choqok::UI::PostWidget* newWidget)
+void UnTiny::slotAddNewPostWidgets(const QList<Choqok::UI::PostWidget*> &newWidgets)
 {
-    postsQueue.enqueue(newWidget);
+    for (Choqok::UI::PostWidget *newWidget: newWidgets) {
+        postsQueue.enqueue(newWidget);
+    }
     if(state == Stopped){
         state = Running;
         QTimer::singleShot(1000, this, SLOT(startParsing()));
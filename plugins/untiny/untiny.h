@@ -51,7 +51,7 @@ public:
     ~UnTiny();
 
 protected Q_SLOTS:
-    void slotAddNewPostWidget( Choqok::UI::PostWidget *newWidget );
+    void slotAddNewPostWidgets(const QList<Choqok::UI::PostWidget *> &newWidgets);
     void slot301Redirected(KIO::Job*,QUrl,QUrl);
     void startParsing();
 
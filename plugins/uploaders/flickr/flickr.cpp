@@ -31,7 +31,7 @@
 #include <KIO/StoredTransferJob>
 #include <KPluginFactory>
 
-#include "mediamanager.h"
+#include "multipartformdata.h"
 #include "passwordmanager.h"
 
 #include "flickrsettings.h"
@@ -104,23 +104,21 @@ void Flickr::upload(const QUrl &localUrl, const QByteArray &medium, const QByteA
 
     formdata[QLatin1String("api_sig")] = createSign("auth_token" + token.toUtf8() + preSign.toUtf8());
 
-    QMap<QString, QByteArray> mediafile;
-    mediafile[QLatin1String("name")] = "photo";
-    mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-    mediafile[QLatin1String("mediumType")] = mediumType;
-    mediafile[QLatin1String("medium")] = medium;
-    QList< QMap<QString, QByteArray> > listMediafiles;
-    listMediafiles.append(mediafile);
-
-    QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+    Choqok::MultipartFormData *form = new Choqok::MultipartFormData;
+    if (!form->addFile(QLatin1String("photo"), localUrl, mediumType, medium)) {
+        delete form;
+        Q_EMIT uploadingFailed(localUrl, i18n("The medium file is empty or cannot be read."));
+        return;
+    }
+    form->addFields(formdata);
 
-    KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
+    KIO::StoredTransferJob *job = form->post(url);
     if (!job) {
         qCritical() << "Cannot create a http POST request!";
         return;
     }
-    job->addMetaData(QLatin1String("content-type"), QLatin1String("Content-Type: multipart/form-data; boundary=AaB03x"));
     mUrlMap[job] = localUrl;
+    watchProgress(job, localUrl);
     connect(job, &KIO::StoredTransferJob::result, this, &Flickr::slotUpload);
     job->start();
 }
@@ -31,7 +31,7 @@
 #include <KLocalizedString>
 #include <KPluginFactory>
 
-#include "mediamanager.h"
+#include "multipartformdata.h"
 
 const static QString apiKey = QLatin1String("ZMWLXQBOfb570310607355f90c601148a3203f0f");
 
@@ -58,23 +58,21 @@ void ImageShack::upload(const QUrl &localUrl, const QByteArray &medium, const QB
     formdata[QLatin1String("key")] = apiKey.toLatin1();
     formdata[QLatin1String("rembar")] = "1";
 
-    QMap<QString, QByteArray> mediafile;
-    mediafile[QLatin1String("name")] = "fileupload";
-    mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-    mediafile[QLatin1String("mediumType")] = mediumType;
-    mediafile[QLatin1String("medium")] = medium;
-    QList< QMap<QString, QByteArray> > listMediafiles;
-    listMediafiles.append(mediafile);
-
-    QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+    Choqok::MultipartFormData *form = new Choqok::MultipartFormData;
+    if (!form->addFile(QLatin1String("fileupload"), localUrl, mediumType, medium)) {
+        delete form;
+        Q_EMIT uploadingFailed(localUrl, i18n("The medium file is empty or cannot be read."));
+        return;
+    }
+    form->addFields(formdata);
 
-    KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
+    KIO::StoredTransferJob *job = form->post(url);
     if (!job) {
         qCritical() << "Cannot create a http POST request!";
         return;
     }
-    job->addMetaData(QLatin1String("content-type"), QLatin1String("Content-Type: multipart/form-data; boundary=AaB03x"));
     mUrlMap[job] = localUrl;
+    watchProgress(job, localUrl);
     connect(job, &KIO::StoredTransferJob::result, this, &ImageShack::slotUpload);
     job->start();
 }
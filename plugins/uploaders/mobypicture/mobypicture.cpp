@@ -30,7 +30,7 @@
 #include <KPluginFactory>
 
 #include "accountmanager.h"
-#include "mediamanager.h"
+#include "multipartformdata.h"
 #include "passwordmanager.h"
 
 #include "twitterapiaccount.h"
@@ -73,17 +73,15 @@ void Mobypicture::upload(const QUrl &localUrl, const QByteArray &medium, const Q
         formdata[QLatin1String("key")] = apiKey;
         formdata[QLatin1String("message")] = QString().toUtf8();
 
-        QMap<QString, QByteArray> mediafile;
-        mediafile[QLatin1String("name")] = "media";
-        mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-        mediafile[QLatin1String("mediumType")] = mediumType;
-        mediafile[QLatin1String("medium")] = medium;
-        QList< QMap<QString, QByteArray> > listMediafiles;
-        listMediafiles.append(mediafile);
-
-        QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+        Choqok::MultipartFormData *form = new Choqok::MultipartFormData;
+        if (!form->addFile(QLatin1String("media"), localUrl, mediumType, medium)) {
+            delete form;
+            Q_EMIT uploadingFailed(localUrl, i18n("The medium file is empty or cannot be read."));
+            return;
+        }
+        form->addFields(formdata);
 
-        job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo);
+        job = form->post(url);
         QUrl requrl(QLatin1String("https://api.twitter.com/1/account/verify_credentials.json"));
         QByteArray credentials = acc->oauthInterface()->authorizationHeader(requrl, QNetworkAccessManager::GetOperation);
 
@@ -102,16 +100,15 @@ void Mobypicture::upload(const QUrl &localUrl, const QByteArray &medium, const Q
         formdata[QLatin1String("s")] = "none";
         formdata[QLatin1String("format")] = "json";
 
-        QMap<QString, QByteArray> mediafile;
-        mediafile[QLatin1String("name")] = "i";
-        mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-        mediafile[QLatin1String("mediumType")] = mediumType;
-        mediafile[QLatin1String("medium")] = medium;
-        QList< QMap<QString, QByteArray> > listMediafiles;
-        listMediafiles.append(mediafile);
-        QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+        Choqok::MultipartFormData *form = new Choqok::MultipartFormData;
+        if (!form->addFile(QLatin1String("i"), localUrl, mediumType, medium)) {
+            delete form;
+            Q_EMIT uploadingFailed(localUrl, i18n("The medium file is empty or cannot be read."));
+            return;
+        }
+        form->addFields(formdata);
 
-        job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
+        job = form->post(url);
         job->addMetaData(QLatin1String("Authorization"),
                          QLatin1String("Basic ") + QLatin1String(QStringLiteral("%1:%2").arg(login).arg(pass).toUtf8().toBase64()));
     }
@@ -120,9 +117,8 @@ void Mobypicture::upload(const QUrl &localUrl, const QByteArray &medium, const Q
         qCritical() << "Cannot create a http POST request!";
         return;
     }
-    job->addMetaData(QLatin1String("content-type"),
-                     QLatin1String("Content-Type: multipart/form-data; boundary=AaB03x"));
     mUrlMap[job] = localUrl;
+    watchProgress(job, localUrl);
     connect(job, &KIO::StoredTransferJob::result, this, &Mobypicture::slotUpload);
     job->start();
 }
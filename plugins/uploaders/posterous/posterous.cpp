@@ -30,7 +30,7 @@
 #include <KPluginFactory>
 
 #include "accountmanager.h"
-#include "mediamanager.h"
+#include "multipartformdata.h"
 #include "passwordmanager.h"
 
 #include "twitterapiaccount.h"
@@ -96,16 +96,14 @@ void Posterous::upload(const QUrl &localUrl, const QByteArray &medium, const QBy
             formdata[QLatin1String("source")] = QCoreApplication::applicationName().toLatin1();
             formdata[QLatin1String("api_token")] = token.toUtf8();
 
-            QMap<QString, QByteArray> mediafile;
-            mediafile[QLatin1String("name")] = "media";
-            mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-            mediafile[QLatin1String("mediumType")] = mediumType;
-            mediafile[QLatin1String("medium")] = medium;
-            QList< QMap<QString, QByteArray> > listMediafiles;
-            listMediafiles.append(mediafile);
-
-            QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
-            job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo);
+            Choqok::MultipartFormData *form = new Choqok::MultipartFormData;
+            if (!form->addFile(QLatin1String("media"), localUrl, mediumType, medium)) {
+                delete form;
+                Q_EMIT uploadingFailed(localUrl, i18n("The medium file is empty or cannot be read."));
+                return;
+            }
+            form->addFields(formdata);
+            job = form->post(url);
             job->addMetaData(QLatin1String("customHTTPHeader"),
                              QLatin1String("Authorization: Basic ") +
                              QLatin1String(QStringLiteral("%1:%2").arg(login).arg(pass).toUtf8().toBase64()));
@@ -128,17 +126,15 @@ void Posterous::upload(const QUrl &localUrl, const QByteArray &medium, const QBy
         formdata[QLatin1String("source")] = QCoreApplication::applicationName().toLatin1();
         formdata[QLatin1String("sourceLink")] = "https://choqok.kde.org/";
 
-        QMap<QString, QByteArray> mediafile;
-        mediafile[QLatin1String("name")] = "media";
-        mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-        mediafile[QLatin1String("mediumType")] = mediumType;
-        mediafile[QLatin1String("medium")] = medium;
-        QList< QMap<QString, QByteArray> > listMediafiles;
-        listMediafiles.append(mediafile);
-
-        QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+        Choqok::MultipartFormData *form = new Choqok::MultipartFormData;
+        if (!form->addFile(QLatin1String("media"), localUrl, mediumType, medium)) {
+            delete form;
+            Q_EMIT uploadingFailed(localUrl, i18n("The medium file is empty or cannot be read."));
+            return;
+        }
+        form->addFields(formdata);
 
-        KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo);
+        job = form->post(url);
         QUrl requrl(QLatin1String("https://api.twitter.com/1/account/verify_credentials.json"));
         QByteArray credentials = acc->oauthInterface()->authorizationHeader(requrl, QNetworkAccessManager::GetOperation);
 
@@ -150,9 +146,8 @@ void Posterous::upload(const QUrl &localUrl, const QByteArray &medium, const QBy
         qCritical() << "Cannot create a http POST request!";
         return;
     }
-    job->addMetaData(QStringLiteral("content-type"),
-                     QStringLiteral("Content-Type: multipart/form-data; boundary=AaB03x"));
     mUrlMap[job] = localUrl;
+    watchProgress(job, localUrl);
     connect(job, &KIO::StoredTransferJob::result, this, &Posterous::slotUpload);
     job->start();
 }
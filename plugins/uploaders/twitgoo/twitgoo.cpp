@@ -30,7 +30,7 @@
 #include <KPluginFactory>
 
 #include "accountmanager.h"
-#include "mediamanager.h"
+#include "multipartformdata.h"
 #include "passwordmanager.h"
 
 #include "twitterapiaccount.h"
@@ -70,17 +70,15 @@ void Twitgoo::upload(const QUrl &localUrl, const QByteArray &medium, const QByte
     formdata[QLatin1String("source")] = QCoreApplication::applicationName().toLatin1();
     formdata[QLatin1String("format")] = "json";
 
-    QMap<QString, QByteArray> mediafile;
-    mediafile[QLatin1String("name")] = "media";
-    mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-    mediafile[QLatin1String("mediumType")] = mediumType;
-    mediafile[QLatin1String("medium")] = medium;
-    QList< QMap<QString, QByteArray> > listMediafiles;
-    listMediafiles.append(mediafile);
-
-    QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+    Choqok::MultipartFormData *form = new Choqok::MultipartFormData;
+    if (!form->addFile(QLatin1String("media"), localUrl, mediumType, medium)) {
+        delete form;
+        Q_EMIT uploadingFailed(localUrl, i18n("The medium file is empty or cannot be read."));
+        return;
+    }
+    form->addFields(formdata);
 
-    KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
+    KIO::StoredTransferJob *job = form->post(url);
     job->addMetaData(QStringLiteral("customHTTPHeader"),
                      QStringLiteral("X-Auth-Service-Provider: https://api.twitter.com/1/account/verify_credentials.json"));
     QUrl requrl(QLatin1String("https://api.twitter.com/1/account/verify_credentials.json"));
@@ -91,9 +89,8 @@ void Twitgoo::upload(const QUrl &localUrl, const QByteArray &medium, const QByte
         qCritical() << "Cannot create a http POST request!";
         return;
     }
-    job->addMetaData(QStringLiteral("content-type"),
-                     QStringLiteral("Content-Type: multipart/form-data; boundary=AaB03x"));
     mUrlMap[job] = localUrl;
+    watchProgress(job, localUrl);
     connect(job, &KIO::StoredTransferJob::result, this, &Twitgoo::slotUpload);
     job->start();
 }
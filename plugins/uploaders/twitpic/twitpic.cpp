@@ -30,7 +30,7 @@
 #include <KPluginFactory>
 
 #include "accountmanager.h"
-#include "mediamanager.h"
+#include "multipartformdata.h"
 
 #include <QtOAuth/QtOAuth>
 
@@ -70,17 +70,15 @@ void Twitpic::upload(const QUrl &localUrl, const QByteArray &medium, const QByte
     QMap<QString, QByteArray> formdata;
     formdata["key"] = "b66d1f2dc90b53ca1fcd75319cda0b72";
 
-    QMap<QString, QByteArray> mediafile;
-    mediafile["name"] = "media";
-    mediafile["filename"] = localUrl.fileName().toUtf8();
-    mediafile["mediumType"] = mediumType;
-    mediafile["medium"] = medium;
-    QList< QMap<QString, QByteArray> > listMediafiles;
-    listMediafiles.append(mediafile);
-
-    QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+    Choqok::MultipartFormData *form = new Choqok::MultipartFormData;
+    if (!form->addFile(QLatin1String("media"), localUrl, mediumType, medium)) {
+        delete form;
+        Q_EMIT uploadingFailed(localUrl, i18n("The medium file is empty or cannot be read."));
+        return;
+    }
+    form->addFields(formdata);
 
-    KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
+    KIO::StoredTransferJob *job = form->post(url);
     job->addMetaData(QStringLiteral("customHTTPHeader"),
                      QStringLiteral("X-Auth-Service-Provider: https://api.twitter.com/1/account/verify_credentials.json"));
     QOAuth::ParamMap params;
@@ -100,9 +98,8 @@ void Twitpic::upload(const QUrl &localUrl, const QByteArray &medium, const QByte
         qCritical() << "Cannot create a http POST request!";
         return;
     }
-    job->addMetaData(QStringLiteral("content-type"),
-                     QStringLiteral("Content-Type: multipart/form-data; boundary=AaB03x"));
     mUrlMap[job] = localUrl;
+    watchProgress(job, localUrl);
     connect(job, SIGNAL(result(KJob*)),
             SLOT(slotUpload(KJob*)));
     job->start();
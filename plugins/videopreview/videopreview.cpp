@@ -54,8 +54,8 @@ VideoPreview::VideoPreview(QObject *parent, const QList< QVariant > &)
     : Choqok::Plugin(QLatin1String("choqok_videopreview"), parent)
     , state(Stopped)
 {
-    connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetAdded,
-            this, &VideoPreview::slotAddNewPostWidget);
+    connect(Choqok::UI::Global::SessionManager::self(), &Choqok::UI::Global::SessionManager::newPostWidgetsAdded,
+            this, &VideoPreview::slotAddNewPostWidgets);
     connect(Choqok::ShortenManager::self(), &Choqok::ShortenManager::newUnshortenedUrl,
             this, &VideoPreview::slotNewUnshortenedUrl);
 }
@@ -65,9 +65,11 @@ VideoPreview::~VideoPreview()
 
 }
 
-void VideoPreview::slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget)
+void VideoPreview::slotAddNewPostWidgets(const QList<Choqok::UI::PostWidget *> &newWidgets)
 {
-    postsQueue.enqueue(newWidget);
+    for (Choqok::UI::PostWidget *newWidget: newWidgets) {
+        postsQueue.enqueue(newWidget);
+    }
     if (state == Stopped) {
         state = Running;
         QTimer::singleShot(1000, this, SLOT(startParsing()));
@@ -81,14 +83,16 @@ void VideoPreview::slotNewUnshortenedUrl(Choqok::UI::PostWidget *widget, const Q
         QUrl thisurl(mYouTubeRegExp.cap(0));
         QUrlQuery thisurlQuery(thisurl);
         QUrl thumbUrl = parseYoutube(thisurlQuery.queryItemValue(QLatin1String("v")), widget);
-        connect(Choqok::MediaManager::self(), &Choqok::MediaManager::imageFetched,
-                this, &VideoPreview::slotImageFetched);
-        Choqok::MediaManager::self()->fetchImage(thumbUrl, Choqok::MediaManager::Async);
+        const QPixmap pixmap = Choqok::MediaManager::self()->fetchImage(thumbUrl, this, "slotImageFetched");
+        if (!pixmap.isNull()) {
+            slotImageFetched(thumbUrl, pixmap);
+        }
     } else if (mVimeoRegExp.indexIn(toUrl.toDisplayString()) != -1) {
         QUrl thumbUrl = parseVimeo(mVimeoRegExp.cap(3), widget);
-        connect(Choqok::MediaManager::self(), &Choqok::MediaManager::imageFetched,
-                this, &VideoPreview::slotImageFetched);
-        Choqok::MediaManager::self()->fetchImage(thumbUrl, Choqok::MediaManager::Async);
+        const QPixmap pixmap = Choqok::MediaManager::self()->fetchImage(thumbUrl, this, "slotImageFetched");
+        if (!pixmap.isNull()) {
+            slotImageFetched(thumbUrl, pixmap);
+        }
     }
 
 }
@@ -142,10 +146,10 @@ void VideoPreview::parse(QPointer<Choqok::UI::PostWidget> postToParse)
     }
 
     for (const QUrl &thumb_url: thumbList) {
-        connect(Choqok::MediaManager::self(), &Choqok::MediaManager::imageFetched,
-                this, &VideoPreview::slotImageFetched);
-
-        Choqok::MediaManager::self()->fetchImage(thumb_url, Choqok::MediaManager::Async);
+        const QPixmap pixmap = Choqok::MediaManager::self()->fetchImage(thumb_url, this, "slotImageFetched");
+        if (!pixmap.isNull()) {
+            slotImageFetched(thumb_url, pixmap);
+        }
     }
 
 }
@@ -52,7 +52,7 @@ public:
     ~VideoPreview();
 
 protected Q_SLOTS:
-    void slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget);
+    void slotAddNewPostWidgets(const QList<Choqok::UI::PostWidget *> &newWidgets);
     void startParsing();
     void slotImageFetched(const QUrl &remoteUrl, const QPixmap &pixmap);
     void slotNewUnshortenedUrl(Choqok::UI::PostWidget *widget, const QUrl &fromUrl, const QUrl &toUrl);